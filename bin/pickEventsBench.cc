@@ -0,0 +1,399 @@
+// Benchmark of pick list loading and matching on synthetic lists.
+//
+//   pickEventsBench [--events N,...] [--runs R,...] [--hit-rate f,...] [--queries Q]
+//                   [--backends sorted,hash,compressed] [--fpr f] [--seed s]
+//                   [--tmp DIR] [--json] [-o results]
+//
+// For every combination of list size, number of runs (events per run is
+// their ratio) and hit rate, a list is drawn at random and indexed with
+// every backend. Reported per backend:
+//   build_s, binary_s       index built from columns, and from a mapped binary list
+//   index_bytes             memory held by the index built from columns: backend,
+//                           prefilter and per-run arrays
+//   peak_bytes              peak resident memory added while building it
+//   random_ns, p50_ns,      single lookups (PickEventsIndex::contains) in random
+//   p99_ns                  order: mean, and median and 99th percentile over
+//                           blocks of 64 lookups
+//   ordered_ns              lookups ordered by run and event, as in MINIAOD, through
+//                           the run-scoped cursor of PickEvents2 (sorted per-run
+//                           arrays only, else through contains)
+//   batch_mlps              matchBatch throughput, million lookups per second
+// One CSV line per backend and workload (header first), or a JSON array.
+// Each backend runs in a child process so that peak memory is its own.
+
+#include "JetMETStudies/JMEAnalyzer/interface/PickEventsIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+#include "JetMETStudies/JMEAnalyzer/interface/RunCursor.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+   struct Workload {
+      ULong64_t nEvents;
+      ULong64_t nRuns;
+      double    hitRate;
+   };
+
+   // plain numbers only: sent back from the child process as raw bytes
+   struct Measurement {
+      double    buildSeconds, binarySeconds;
+      Long64_t  indexBytes, peakBytes;
+      double    randomNs, p50Ns, p99Ns, orderedNs, batchMlps;
+      ULong64_t hits;
+   };
+
+   struct Result {
+      Workload    workload;
+      std::string backend;
+      Measurement m;
+   };
+
+   struct Queries {
+      std::vector<Long64_t> runs, events;
+   };
+
+   const Long64_t kFirstRun = 297050;
+
+   double seconds(std::chrono::steady_clock::time_point start)
+   {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   // current and peak resident set size from /proc, 0 where it is not available
+   Long64_t residentBytes(const char *field = "VmRSS:")
+   {
+      std::ifstream status("/proc/self/status");
+      std::string key;
+      Long64_t kb = 0;
+      while (status >> key) {
+         if (key == field) {
+            status >> kb;
+            break;
+         }
+         status.ignore(256, '\n');
+      }
+      return kb * 1024;
+   }
+
+   // restarts the peak (VmHWM) from the current resident size
+   void resetPeak()
+   {
+      std::ofstream clear("/proc/self/clear_refs");
+      clear << "5";
+   }
+
+   // events spread over a range 64 times the events per run, like the sparse
+   // event numbers of a real selection; lumi from the event number
+   void generate(const Workload &w, std::mt19937_64 &rng, std::vector<Long64_t> &runs,
+                 std::vector<Long64_t> &events, std::vector<Long64_t> &lumis)
+   {
+      const ULong64_t perRun = std::max<ULong64_t>(1, w.nEvents / w.nRuns);
+      const ULong64_t range = perRun * 64;
+      runs.resize(w.nEvents);
+      events.resize(w.nEvents);
+      lumis.resize(w.nEvents);
+      for (ULong64_t i = 0; i < w.nEvents; ++i) {
+         runs[i] = kFirstRun + Long64_t(rng() % w.nRuns);
+         events[i] = Long64_t(rng() % range);
+         lumis[i] = 1 + events[i] / 1000;
+      }
+   }
+
+   // hitRate of the queries are list entries, the rest random events of the
+   // same runs, a few of them in runs not in the list; ~1.5% of the random ones
+   // hit by chance, the true number is counted
+   Queries makeQueries(const Workload &w, ULong64_t n, std::mt19937_64 &rng, const std::vector<Long64_t> &runs,
+                       const std::vector<Long64_t> &events)
+   {
+      const ULong64_t range = std::max<ULong64_t>(1, w.nEvents / w.nRuns) * 64;
+      std::uniform_real_distribution<double> coin(0, 1);
+      Queries q;
+      q.runs.resize(n);
+      q.events.resize(n);
+      for (ULong64_t i = 0; i < n; ++i) {
+         if (coin(rng) < w.hitRate) {
+            const ULong64_t k = rng() % runs.size();
+            q.runs[i] = runs[k];
+            q.events[i] = events[k];
+         } else {
+            q.runs[i] = kFirstRun + Long64_t(rng() % (w.nRuns + w.nRuns / 16 + 1));
+            q.events[i] = Long64_t(rng() % range);
+         }
+      }
+      return q;
+   }
+
+   Queries sorted(const Queries &q)
+   {
+      std::vector<size_t> order(q.runs.size());
+      for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+      std::sort(order.begin(), order.end(), [&q](size_t a, size_t b) {
+         return q.runs[a] < q.runs[b] || (q.runs[a] == q.runs[b] && q.events[a] < q.events[b]);
+      });
+      Queries s;
+      for (size_t i : order) {
+         s.runs.push_back(q.runs[i]);
+         s.events.push_back(q.events[i]);
+      }
+      return s;
+   }
+
+   // mean, median and 99th percentile (ns per lookup) over blocks of 64
+   void timeRandom(const PickEventsIndex &index, const Queries &q, Measurement &r)
+   {
+      const size_t block = 64;
+      std::vector<double> perBlock;
+      perBlock.reserve(q.runs.size() / block + 1);
+      ULong64_t hits = 0;
+      auto all = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < q.runs.size(); i += block) {
+         const size_t end = std::min(q.runs.size(), i + block);
+         auto start = std::chrono::steady_clock::now();
+         for (size_t j = i; j < end; ++j) hits += index.contains(q.runs[j], q.events[j]);
+         perBlock.push_back(seconds(start) * 1e9 / (end - i));
+      }
+      r.randomNs = seconds(all) * 1e9 / std::max<size_t>(1, q.runs.size());
+      r.hits = hits;
+      std::sort(perBlock.begin(), perBlock.end());
+      r.p50Ns = perBlock.empty() ? 0 : perBlock[perBlock.size() / 2];
+      r.p99Ns = perBlock.empty() ? 0 : perBlock[std::min(perBlock.size() - 1, perBlock.size() * 99 / 100)];
+   }
+
+   // same steps as PickEvents2::match with runScoped set
+   double timeOrdered(const PickEventsIndex &index, const Queries &q)
+   {
+      const EventListView *list = index.list();
+      RunCursor cursor;
+      ULong64_t hits = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < q.runs.size(); ++i) {
+         if (!list) {
+            hits += index.contains(q.runs[i], q.events[i]);
+            continue;
+         }
+         if (!cursor.pinned(q.runs[i])) {
+            const size_t ir = list->findRun(q.runs[i]);
+            if (ir == list->nRuns()) cursor.pin(q.runs[i], 0, 0);
+            else cursor.pin(q.runs[i], list->events(ir), list->nEvents(ir));
+         }
+         hits += cursor.contains(q.events[i]);
+      }
+      const double ns = seconds(start) * 1e9 / std::max<size_t>(1, q.runs.size());
+      // keeps the loop from being optimized away
+      if (hits == ~0ULL) std::cerr << hits << std::endl;
+      return ns;
+   }
+
+   double timeBatch(const PickEventsIndex &index, const Queries &q)
+   {
+      std::vector<ULong64_t> mask;
+      auto start = std::chrono::steady_clock::now();
+      index.matchBatch(q.runs.data(), q.events.data(), q.runs.size(), mask);
+      const double s = seconds(start);
+      return s > 0 ? q.runs.size() / s / 1e6 : 0;
+   }
+
+   void measureHere(const PickEventsIndex::Options &options, const std::vector<Long64_t> &runs,
+                    const std::vector<Long64_t> &events, const std::vector<Long64_t> &lumis,
+                    const std::string &binary, const Queries &random, const Queries &ordered, Measurement &m)
+   {
+      resetPeak();
+      const Long64_t rssBefore = residentBytes();
+      auto start = std::chrono::steady_clock::now();
+      auto index = PickEventsIndex::fromColumns(runs, events, lumis, options);
+      m.buildSeconds = seconds(start);
+      m.peakBytes = std::max<Long64_t>(0, residentBytes("VmHWM:") - rssBefore);
+      m.indexBytes = index->index().bytes();
+      if (index->filter()) m.indexBytes += index->filter()->bytes();
+      if (index->list()) m.indexBytes += index->list()->totalEvents() * sizeof(Long64_t);
+
+      std::string error;
+      start = std::chrono::steady_clock::now();
+      auto mapped = PickEventsIndex::fromBinary(binary, false, options, error);
+      m.binarySeconds = mapped ? seconds(start) : -1;
+      mapped.reset();
+
+      timeRandom(*index, random, m);
+      m.orderedNs = timeOrdered(*index, ordered);
+      m.batchMlps = timeBatch(*index, random);
+   }
+
+   // measureHere in a child process, whose peak memory starts where ours is now
+   bool measure(const PickEventsIndex::Options &options, const std::vector<Long64_t> &runs,
+                const std::vector<Long64_t> &events, const std::vector<Long64_t> &lumis,
+                const std::string &binary, const Queries &random, const Queries &ordered, Measurement &m)
+   {
+      // free pages kept by malloc would hide the growth of the child
+      malloc_trim(0);
+      int fds[2];
+      if (pipe(fds) != 0) return false;
+      const pid_t pid = fork();
+      if (pid < 0) return false;
+      if (pid == 0) {
+         close(fds[0]);
+         Measurement child;
+         measureHere(options, runs, events, lumis, binary, random, ordered, child);
+         const bool ok = write(fds[1], &child, sizeof(child)) == sizeof(child);
+         _exit(ok ? 0 : 1);
+      }
+      close(fds[1]);
+      const bool ok = read(fds[0], &m, sizeof(m)) == sizeof(m);
+      close(fds[0]);
+      int status = 0;
+      waitpid(pid, &status, 0);
+      return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+   }
+
+   std::vector<double> parseList(const char *arg)
+   {
+      std::vector<double> values;
+      std::stringstream ss(arg);
+      std::string item;
+      while (std::getline(ss, item, ',')) values.push_back(std::atof(item.c_str()));
+      return values;
+   }
+
+   std::vector<std::string> parseNames(const char *arg)
+   {
+      std::vector<std::string> names;
+      std::stringstream ss(arg);
+      std::string item;
+      while (std::getline(ss, item, ',')) names.push_back(item);
+      return names;
+   }
+
+   void writeCsv(std::ostream &os, const std::vector<Result> &results)
+   {
+      os << "events,runs,events_per_run,hit_rate,backend,build_s,binary_s,index_bytes,peak_bytes,"
+         << "random_ns,p50_ns,p99_ns,ordered_ns,batch_mlps,hits\n";
+      for (const Result &r : results)
+         os << r.workload.nEvents << "," << r.workload.nRuns << "," << r.workload.nEvents / r.workload.nRuns << ","
+            << r.workload.hitRate << "," << r.backend << "," << r.m.buildSeconds << "," << r.m.binarySeconds << ","
+            << r.m.indexBytes << "," << r.m.peakBytes << "," << r.m.randomNs << "," << r.m.p50Ns << "," << r.m.p99Ns
+            << "," << r.m.orderedNs << "," << r.m.batchMlps << "," << r.m.hits << "\n";
+   }
+
+   void writeJson(std::ostream &os, const std::vector<Result> &results)
+   {
+      os << "[";
+      for (size_t i = 0; i < results.size(); ++i) {
+         const Result &r = results[i];
+         os << (i ? ",\n " : "") << "{\"events\": " << r.workload.nEvents << ", \"runs\": " << r.workload.nRuns
+            << ", \"events_per_run\": " << r.workload.nEvents / r.workload.nRuns
+            << ", \"hit_rate\": " << r.workload.hitRate << ", \"backend\": \"" << r.backend << "\""
+            << ", \"build_s\": " << r.m.buildSeconds << ", \"binary_s\": " << r.m.binarySeconds
+            << ", \"index_bytes\": " << r.m.indexBytes << ", \"peak_bytes\": " << r.m.peakBytes
+            << ", \"random_ns\": " << r.m.randomNs << ", \"p50_ns\": " << r.m.p50Ns << ", \"p99_ns\": " << r.m.p99Ns
+            << ", \"ordered_ns\": " << r.m.orderedNs << ", \"batch_mlps\": " << r.m.batchMlps
+            << ", \"hits\": " << r.m.hits << "}";
+      }
+      os << "]\n";
+   }
+}
+
+int main(int argc, char **argv)
+{
+   std::vector<double> sizes = {1e6}, runCounts = {100}, hitRates = {0.01};
+   std::vector<std::string> backends = {"sorted", "hash", "compressed"};
+   ULong64_t nQueries = 1000000, seed = 1;
+   double fpr = 0;
+   const char *tmp = std::getenv("TMPDIR");
+   std::string tmpDir = tmp && *tmp ? tmp : "/tmp", output;
+   bool json = false;
+   for (int i = 1; i < argc; ++i) {
+      const bool more = i + 1 < argc;
+      if (std::strcmp(argv[i], "--events") == 0 && more) sizes = parseList(argv[++i]);
+      else if (std::strcmp(argv[i], "--runs") == 0 && more) runCounts = parseList(argv[++i]);
+      else if (std::strcmp(argv[i], "--hit-rate") == 0 && more) hitRates = parseList(argv[++i]);
+      else if (std::strcmp(argv[i], "--queries") == 0 && more) nQueries = std::atof(argv[++i]);
+      else if (std::strcmp(argv[i], "--backends") == 0 && more) backends = parseNames(argv[++i]);
+      else if (std::strcmp(argv[i], "--fpr") == 0 && more) fpr = std::atof(argv[++i]);
+      else if (std::strcmp(argv[i], "--seed") == 0 && more) seed = std::atoll(argv[++i]);
+      else if (std::strcmp(argv[i], "--tmp") == 0 && more) tmpDir = argv[++i];
+      else if (std::strcmp(argv[i], "--json") == 0) json = true;
+      else if (std::strcmp(argv[i], "-o") == 0 && more) output = argv[++i];
+      else {
+         std::cerr << "usage: " << argv[0] << " [--events N,...] [--runs R,...] [--hit-rate f,...] [--queries Q]\n"
+                   << "       [--backends sorted,hash,compressed] [--fpr f] [--seed s] [--tmp DIR] [--json] [-o results]"
+                   << std::endl;
+         return 1;
+      }
+   }
+   for (const std::string &name : backends) {
+      PickEventsIndex::Backend backend;
+      if (!PickEventsIndex::backendFromName(name, backend)) {
+         std::cerr << "unknown backend '" << name << "', expected sorted, hash or compressed" << std::endl;
+         return 1;
+      }
+   }
+
+   std::vector<Result> results;
+   char name[64];
+   std::snprintf(name, sizeof(name), "/pickevents_bench_%d.pevl", int(getpid()));
+   const std::string binary = tmpDir + name;
+   for (double size : sizes) {
+      for (double nRuns : runCounts) {
+         for (double hitRate : hitRates) {
+            const Workload w{std::max<ULong64_t>(1, size), std::max<ULong64_t>(1, nRuns), hitRate};
+            std::mt19937_64 rng(seed);
+            std::vector<Long64_t> runs, events, lumis;
+            generate(w, rng, runs, events, lumis);
+            const Queries random = makeQueries(w, nQueries, rng, runs, events);
+            const Queries ordered = sorted(random);
+
+            // the binary list read back by every backend
+            {
+               auto sortedIndex = PickEventsIndex::fromColumns(runs, events, lumis, PickEventsIndex::Options());
+               EventListWriter writer(binary);
+               writer.addList(*sortedIndex->list());
+               const LumiIndex &l = sortedIndex->lumis();
+               for (size_t i = 0; i < l.size(); ++i) writer.addLumi(l.key(i), l.count(i));
+               if (!writer.close()) {
+                  std::cerr << "cannot write " << binary << std::endl;
+                  return 1;
+               }
+            }
+
+            for (const std::string &backendName : backends) {
+               PickEventsIndex::Backend backend;
+               PickEventsIndex::backendFromName(backendName, backend);
+               Result r;
+               r.workload = w;
+               r.backend = backendName;
+               if (!measure(PickEventsIndex::Options(backend, fpr), runs, events, lumis, binary, random, ordered, r.m)) {
+                  std::cerr << "measurement of " << backendName << " failed" << std::endl;
+                  std::remove(binary.c_str());
+                  return 1;
+               }
+               results.push_back(r);
+               std::cerr << w.nEvents << " events, " << w.nRuns << " runs, hit rate " << w.hitRate << ", "
+                         << backendName << ": " << r.m.randomNs << " ns/lookup" << std::endl;
+            }
+         }
+      }
+   }
+   std::remove(binary.c_str());
+
+   std::ofstream file;
+   if (!output.empty()) {
+      file.open(output.c_str());
+      if (!file) {
+         std::cerr << "cannot create " << output << std::endl;
+         return 1;
+      }
+   }
+   std::ostream &os = output.empty() ? std::cout : file;
+   if (json) writeJson(os, results);
+   else writeCsv(os, results);
+   return 0;
+}
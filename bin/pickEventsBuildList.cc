@@ -0,0 +1,138 @@
+// Converts a ROOT (TTree 'tree' with run/event/lumi branches) or text
+// event list into the binary format of EventListFile.h, which
+// PickEvents2::LoadBinary maps read-only at startup.
+//
+//   pickEventsBuildList <list.root | list.txt...> [-o out.pevl] [--cache-dir DIR] [-j threads]
+//
+// Without -o the output goes to DIR (default $PICKEVENTS_CACHE, else /tmp)
+// under a name derived from the input checksum, and an existing file built
+// from the same input is reused. The path of the binary list is printed.
+//
+// Text lists are in the PickEvents3 format of TextEventList.h (one event
+// per line, typically one file per run) and are parsed on -j threads.
+
+#include "JetMETStudies/JMEAnalyzer/interface/PickEvents2.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+#include "JetMETStudies/JMEAnalyzer/interface/LumiIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/TextEventList.h"
+#include <TFile.h>
+#include <TTree.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+   return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool buildFromRoot(const std::string &input, const std::string &output, ULong64_t checksum)
+{
+   TFile *f = TFile::Open(input.c_str());
+   if (!f || f->IsZombie()) {
+      std::cerr << "cannot open " << input << std::endl;
+      return false;
+   }
+   TTree *tree = 0;
+   f->GetObject("tree", tree);
+   if (!tree) {
+      std::cerr << "no TTree 'tree' in " << input << std::endl;
+      return false;
+   }
+   PickEvents2 pe(tree);
+   return pe.WriteBinary(output.c_str(), checksum);
+}
+
+static bool buildFromText(const std::vector<std::string> &inputs, const std::string &output, ULong64_t checksum,
+                          UInt_t nThreads)
+{
+   TextEventList text;
+   if (!text.load(inputs, nThreads)) {
+      std::cerr << text.error() << std::endl;
+      return false;
+   }
+   if (text.badLines()) std::cerr << "skipped " << text.badLines() << " malformed lines" << std::endl;
+
+   const TextEventList::Columns &columns = text.columns();
+   std::map<Long64_t, std::vector<Long64_t>> run_to_event_map;
+   std::vector<ULong64_t> lumi_keys;
+   std::vector<Long64_t> *current = 0;
+   Long64_t current_run = -1;
+   for (size_t i = 0; i < columns.runs.size(); ++i) {
+      if (!current || columns.runs[i] != current_run) {
+         current_run = columns.runs[i];
+         current = &run_to_event_map[current_run];
+      }
+      current->push_back(columns.events[i]);
+      if (columns.lumis[i] >= 0) lumi_keys.push_back(LumiIndex::pack(columns.runs[i], columns.lumis[i]));
+   }
+   for (auto &it : run_to_event_map) {
+      std::sort(it.second.begin(), it.second.end());
+      it.second.erase(std::unique(it.second.begin(), it.second.end()), it.second.end());
+   }
+
+   EventListWriter writer(output);
+   if (!writer.good()) return false;
+   writer.addList(MapEventListView(run_to_event_map));
+   LumiIndex lumis(std::move(lumi_keys));
+   for (size_t i = 0; i < lumis.size(); ++i) writer.addLumi(lumis.key(i), lumis.count(i));
+   return writer.close(checksum);
+}
+
+int main(int argc, char **argv)
+{
+   std::vector<std::string> inputs;
+   std::string output, cacheDir;
+   UInt_t nThreads = 0;
+   for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) output = argv[++i];
+      else if (std::strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) cacheDir = argv[++i];
+      else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) nThreads = std::atoi(argv[++i]);
+      else inputs.push_back(argv[i]);
+   }
+   const bool root = inputs.size() == 1 && endsWith(inputs[0], ".root");
+   if (inputs.empty() || (!root && std::any_of(inputs.begin(), inputs.end(),
+                                               [](const std::string &s) { return endsWith(s, ".root"); }))) {
+      std::cerr << "usage: " << argv[0] << " <list.root | list.txt...> [-o out.pevl] [--cache-dir DIR] [-j threads]"
+                << std::endl;
+      return 1;
+   }
+
+   // one checksum over all inputs, in the order given
+   ULong64_t checksum = 0;
+   for (const std::string &input : inputs) {
+      const ULong64_t sum = eventListFileChecksum(input);
+      if (sum == 0) {
+         std::cerr << "cannot read " << input << std::endl;
+         return 1;
+      }
+      checksum = eventListChecksum(&sum, sizeof(sum), checksum);
+   }
+
+   if (output.empty()) {
+      if (cacheDir.empty()) cacheDir = std::getenv("PICKEVENTS_CACHE") ? std::getenv("PICKEVENTS_CACHE") : "/tmp";
+      char name[64];
+      std::snprintf(name, sizeof(name), "/pickevents_%016llx.pevl", (unsigned long long)checksum);
+      output = cacheDir + name;
+
+      MappedEventList cached;
+      if (cached.open(output, true) && cached.header()->sourceChecksum == checksum) {
+         std::cout << output << std::endl;
+         return 0;
+      }
+   }
+
+   // write next to the target and rename, so concurrent jobs never map a partial file
+   const std::string tmp = output + ".tmp." + std::to_string(getpid());
+   bool ok = root ? buildFromRoot(inputs[0], tmp, checksum) : buildFromText(inputs, tmp, checksum, nThreads);
+   if (!ok || std::rename(tmp.c_str(), output.c_str()) != 0) {
+      std::remove(tmp.c_str());
+      std::cerr << "failed to write " << output << std::endl;
+      return 1;
+   }
+   std::cout << output << std::endl;
+   return 0;
+}
@@ -0,0 +1,133 @@
+// Set algebra over event lists (see EventListSetOps.h).
+//
+//   pickEventsCombine <union|intersection|difference> -o out.{pevl|txt|root}
+//                     [--tmp DIR] [--chunk N] <list.pevl | list.root | list.txt>...
+//
+// Binary lists are merged straight from their mapping. ROOT and text lists
+// may be in any order: they are sorted through temporary chunks of N pairs
+// (default 8M, i.e. 128 MB) written to DIR (default $TMPDIR or /tmp).
+// difference keeps the pairs of the first list found in none of the others.
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventListSetOps.h"
+#include "JetMETStudies/JMEAnalyzer/interface/TextEventList.h"
+#include <TFile.h>
+#include <TTree.h>
+#include <TTreeReader.h>
+#include <TTreeReaderValue.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+   return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool spillRoot(const std::string &path, SortedSpill &spill)
+{
+   std::unique_ptr<TFile> f(TFile::Open(path.c_str()));
+   TTree *tree = 0;
+   if (f && !f->IsZombie()) f->GetObject("tree", tree);
+   if (!tree) {
+      std::cerr << "no TTree 'tree' in " << path << std::endl;
+      return false;
+   }
+   TTreeReader reader(tree);
+   TTreeReaderValue<Long64_t> run(reader, "run");
+   TTreeReaderValue<Long64_t> event(reader, "event");
+   while (reader.Next()) spill.add(*run, *event);
+   return true;
+}
+
+static bool spillText(const std::string &path, SortedSpill &spill)
+{
+   TextEventList text;
+   bool ok = text.stream(path, [&spill](const TextEventList::Columns &c) {
+      for (size_t i = 0; i < c.runs.size(); ++i) spill.add(c.runs[i], c.events[i]);
+   });
+   if (!ok) {
+      std::cerr << text.error() << std::endl;
+      return false;
+   }
+   if (text.badLines()) std::cerr << path << ": " << text.badLines() << " malformed lines skipped" << std::endl;
+   return true;
+}
+
+int main(int argc, char **argv)
+{
+   std::vector<std::string> inputs;
+   std::string output;
+   const char *tmp = std::getenv("TMPDIR");
+   std::string tmpDir = tmp && *tmp ? tmp : "/tmp";
+   size_t chunk = 1 << 23;
+   for (int i = 2; i < argc; ++i) {
+      if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) output = argv[++i];
+      else if (std::strcmp(argv[i], "--tmp") == 0 && i + 1 < argc) tmpDir = argv[++i];
+      else if (std::strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) chunk = std::max(1L, std::atol(argv[++i]));
+      else inputs.push_back(argv[i]);
+   }
+
+   EventListSetOp op = kEventListUnion;
+   bool known = argc > 1;
+   if (known && std::strcmp(argv[1], "intersection") == 0) op = kEventListIntersection;
+   else if (known && std::strcmp(argv[1], "difference") == 0) op = kEventListDifference;
+   else if (known && std::strcmp(argv[1], "union") != 0) known = false;
+   if (!known || output.empty() || inputs.empty()) {
+      std::cerr << "usage: " << argv[0] << " <union|intersection|difference> -o out.{pevl|txt|root}"
+                << " [--tmp DIR] [--chunk N] <list.pevl | list.root | list.txt>..." << std::endl;
+      return 1;
+   }
+
+   std::vector<std::unique_ptr<MappedEventListSource>> mapped;
+   std::vector<std::unique_ptr<SortedSpill>>           spills;
+   std::vector<EventListSource*>                       sources;
+   for (const std::string &input : inputs) {
+      if (endsWith(input, ".pevl")) {
+         mapped.emplace_back(new MappedEventListSource());
+         if (!mapped.back()->open(input)) {
+            std::cerr << mapped.back()->error() << std::endl;
+            return 1;
+         }
+         sources.push_back(mapped.back().get());
+         continue;
+      }
+      spills.emplace_back(new SortedSpill(tmpDir, chunk));
+      SortedSpill &spill = *spills.back();
+      if (!(endsWith(input, ".root") ? spillRoot(input, spill) : spillText(input, spill))) return 1;
+      EventListSource *source = spill.finish();
+      if (!source) {
+         std::cerr << spill.error() << std::endl;
+         return 1;
+      }
+      sources.push_back(source);
+   }
+
+   std::unique_ptr<EventListSink> sink;
+   bool good;
+   if (endsWith(output, ".pevl")) {
+      BinaryEventListSink *s = new BinaryEventListSink(output);
+      good = s->good();
+      sink.reset(s);
+   } else if (endsWith(output, ".root")) {
+      RootEventListSink *s = new RootEventListSink(output);
+      good = s->good();
+      sink.reset(s);
+   } else {
+      TextEventListSink *s = new TextEventListSink(output);
+      good = s->good();
+      sink.reset(s);
+   }
+   if (!good) {
+      std::cerr << "cannot create " << output << std::endl;
+      return 1;
+   }
+
+   const ULong64_t n = mergeEventLists(sources, op, *sink);
+   if (!sink->close()) {
+      std::cerr << "failed to write " << output << std::endl;
+      return 1;
+   }
+   std::cout << n << " events written to " << output << std::endl;
+   return 0;
+}
@@ -0,0 +1,182 @@
+// Turns a small frozen pick list into a header compiled into the program
+// (see EmbeddedEventList.h):
+//
+//   pickEventsEmbed <list.root | list.pevl | list.txt...> -n name [-o header.h]
+//
+// The header holds the perfect hash tables of the list as constexpr arrays
+// and registers it as "name". Include it in one source file of the plugin
+// library and set PickEventsEmbeddedList = "name" (or call
+// PickEvents2::LoadEmbedded): the job then reads no list file at startup.
+// Meant for lists of up to some hundred thousand events; the header grows
+// by about 20 bytes of source per event.
+
+#include "JetMETStudies/JMEAnalyzer/interface/PickEvents2.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EmbeddedEventList.h"
+#include <TFile.h>
+#include <TTree.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+   return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+namespace {
+   struct PerfectHash {
+      ULong64_t                  seed;
+      std::vector<EmbeddedEvent> slots;
+      std::vector<UInt_t>        displacements;
+   };
+
+   // Hash and displace: keys are split into buckets of about four, and the
+   // buckets, largest first, each get the smallest displacement that puts
+   // all their keys into free slots. 1.25 slots per key.
+   bool buildPerfectHash(const std::vector<EmbeddedEvent> &events, ULong64_t seed, PerfectHash &ph)
+   {
+      const ULong64_t n = events.size();
+      const ULong64_t nSlots = n + n / 4 + 1, nBuckets = n / 4 + 1;
+      std::vector<std::vector<ULong64_t>> buckets(nBuckets); // hashes
+      for (const EmbeddedEvent &e : events) {
+         const ULong64_t h = EmbeddedEventList::hash(e.run, e.event, seed);
+         buckets[EmbeddedEventList::bucket(h, nBuckets)].push_back(h);
+      }
+      std::vector<ULong64_t> order(nBuckets);
+      for (ULong64_t b = 0; b < nBuckets; ++b) order[b] = b;
+      std::stable_sort(order.begin(), order.end(),
+                       [&buckets](ULong64_t a, ULong64_t b) { return buckets[a].size() > buckets[b].size(); });
+
+      ph.seed = seed;
+      ph.slots.assign(nSlots, EmbeddedEvent{-1, 0});
+      ph.displacements.assign(nBuckets, 0);
+      std::vector<ULong64_t> owner(nSlots, ~0ULL); // hash placed in each slot
+      std::vector<ULong64_t> placed;
+      for (ULong64_t b : order) {
+         const std::vector<ULong64_t> &keys = buckets[b];
+         if (keys.empty()) break;
+         UInt_t d = 0;
+         for (;; ++d) {
+            if (d == (1U << 20)) return false;
+            placed.clear();
+            bool free = true;
+            for (ULong64_t h : keys) {
+               const ULong64_t s = EmbeddedEventList::slot(h, d, nSlots);
+               if (owner[s] != ~0ULL || std::find(placed.begin(), placed.end(), s) != placed.end()) {
+                  free = false;
+                  break;
+               }
+               placed.push_back(s);
+            }
+            if (free) break;
+         }
+         ph.displacements[b] = d;
+         for (size_t i = 0; i < keys.size(); ++i) owner[placed[i]] = keys[i];
+      }
+      // the table only records hashes so far: put the pairs in
+      for (const EmbeddedEvent &e : events) {
+         const ULong64_t h = EmbeddedEventList::hash(e.run, e.event, seed);
+         const ULong64_t s = EmbeddedEventList::slot(h, ph.displacements[EmbeddedEventList::bucket(h, nBuckets)], nSlots);
+         // two pairs with the same 64-bit hash would share the slot
+         if (ph.slots[s].run >= 0) return false;
+         ph.slots[s] = e;
+      }
+      return true;
+   }
+
+   void writeHeader(std::ostream &os, const std::string &name, const std::string &source,
+                    const std::vector<EmbeddedEvent> &events, ULong64_t nRuns, const PerfectHash &ph)
+   {
+      const std::string ns = "pickevents_embedded_" + name;
+      os << "// Generated by pickEventsEmbed from " << source << ": " << events.size() << " events in " << nRuns
+         << " runs.\n"
+         << "// Include in one source file of a library to register the list as \"" << name << "\".\n\n"
+         << "#ifndef PickEventsEmbedded_" << name << "_h\n"
+         << "#define PickEventsEmbedded_" << name << "_h\n\n"
+         << "#include \"JetMETStudies/JMEAnalyzer/interface/EmbeddedEventList.h\"\n\n"
+         << "namespace " << ns << " {\n\n"
+         << "constexpr EmbeddedEvent kSlots[] = {";
+      for (size_t i = 0; i < ph.slots.size(); ++i)
+         os << (i % 4 ? " " : "\n   ") << "{" << ph.slots[i].run << ", " << ph.slots[i].event << "},";
+      os << "\n};\n\n"
+         << "constexpr UInt_t kDisplacements[] = {";
+      for (size_t i = 0; i < ph.displacements.size(); ++i) os << (i % 16 ? " " : "\n   ") << ph.displacements[i] << ",";
+      os << "\n};\n\n"
+         << "constexpr EmbeddedEventList kList(kSlots, " << ph.slots.size() << ", kDisplacements, "
+         << ph.displacements.size() << ", " << ph.seed << "ULL, " << events.size() << ");\n\n";
+      if (!events.empty())
+         os << "static_assert(kList.contains(" << events.front().run << ", " << events.front().event << ") && kList.contains("
+            << events.back().run << ", " << events.back().event << "), \"embedded list " << name << " is inconsistent\");\n\n";
+      os << "static const EmbeddedEventList::Registration kRegistration(\"" << name << "\", kList);\n\n"
+         << "}\n\n"
+         << "#endif\n";
+   }
+}
+
+int main(int argc, char **argv)
+{
+   std::vector<std::string> inputs;
+   std::string name, output;
+   for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) name = argv[++i];
+      else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) output = argv[++i];
+      else inputs.push_back(argv[i]);
+   }
+   const bool identifier = !name.empty() && !std::isdigit((unsigned char)name[0]) &&
+                           std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum((unsigned char)c) || c == '_'; });
+   if (inputs.empty() || !identifier) {
+      std::cerr << "usage: " << argv[0] << " <list.root | list.pevl | list.txt...> -n name [-o header.h]\n"
+                << "       name: letters, digits and '_', not starting with a digit" << std::endl;
+      return 1;
+   }
+
+   TTree *tree = 0;
+   const bool root = inputs.size() == 1 && endsWith(inputs[0], ".root");
+   if (root) {
+      TFile *f = TFile::Open(inputs[0].c_str());
+      if (f && !f->IsZombie()) f->GetObject("tree", tree);
+      if (!tree) {
+         std::cerr << "no TTree 'tree' in " << inputs[0] << std::endl;
+         return 1;
+      }
+   }
+   PickEvents2 pe(tree);
+   bool ok = true;
+   if (root) pe.Loop();
+   else if (inputs.size() == 1 && endsWith(inputs[0], ".pevl")) ok = pe.LoadBinary(inputs[0].c_str());
+   else ok = pe.LoadText(inputs);
+   if (!ok || !pe.index || !pe.index->list()) return 1;
+
+   const EventListView &list = *pe.index->list();
+   std::vector<EmbeddedEvent> events;
+   events.reserve(list.totalEvents());
+   for (size_t i = 0; i < list.nRuns(); ++i)
+      for (size_t j = 0; j < list.nEvents(i); ++j) events.push_back(EmbeddedEvent{list.run(i), list.events(i)[j]});
+
+   PerfectHash ph;
+   ULong64_t seed = 0;
+   while (!buildPerfectHash(events, seed, ph)) {
+      if (++seed == 16) {
+         std::cerr << "no perfect hash found for " << events.size() << " events" << std::endl;
+         return 1;
+      }
+   }
+
+   std::string source = inputs[0];
+   if (inputs.size() > 1) source += " and " + std::to_string(inputs.size() - 1) + " more";
+   if (output.empty()) {
+      writeHeader(std::cout, name, source, events, list.nRuns(), ph);
+      return 0;
+   }
+   std::ofstream out(output.c_str());
+   writeHeader(out, name, source, events, list.nRuns(), ph);
+   out.close();
+   if (!out) {
+      std::cerr << "failed to write " << output << std::endl;
+      return 1;
+   }
+   std::cerr << events.size() << " events in " << list.nRuns() << " runs written to " << output << std::endl;
+   return 0;
+}
@@ -0,0 +1,148 @@
+// Event-to-file locator (see EventFileLocator.h).
+//
+//   pickEventsLocate scan <catalog.txt | file.root...> -o locator.txt
+//      reads the event IDs of every EDM file once (a catalog lists one
+//      file name per line) and adds their events, by (run,lumi), to locator.txt
+//   pickEventsLocate select locator.txt <list.pevl | list.root | list.txt...> [--json]
+//      prints the smallest set of files holding the picked events, as a cff
+//      fragment with fileNames and eventsToProcess, or as JSON per file
+
+#include "JetMETStudies/JMEAnalyzer/interface/PickEvents2.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventFileLocator.h"
+#include "DataFormats/FWLite/interface/Event.h"
+#include "FWCore/FWLite/interface/FWLiteEnabler.h"
+#include <TFile.h>
+#include <TTree.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+   return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool scanFile(const std::string &name, EventFileLocator::File &file)
+{
+   std::unique_ptr<TFile> f(TFile::Open(name.c_str()));
+   if (!f || f->IsZombie()) {
+      std::cerr << "cannot open " << name << std::endl;
+      return false;
+   }
+   std::map<std::pair<Long64_t, Long64_t>, EventFileLocator::Lumi> lumis;
+   // only the event auxiliary is read, no product
+   fwlite::Event ev(f.get());
+   for (ev.toBegin(); !ev.atEnd(); ++ev) {
+      const Long64_t run = ev.id().run(), lumi = ev.luminosityBlock(), event = ev.id().event();
+      auto it = lumis.find(std::make_pair(run, lumi));
+      if (it == lumis.end()) {
+         EventFileLocator::Lumi &l = lumis[std::make_pair(run, lumi)];
+         l = EventFileLocator::Lumi{run, lumi, event, event, 1, std::vector<Long64_t>()};
+         l.events.push_back(event);
+         continue;
+      }
+      EventFileLocator::Lumi &l = it->second;
+      l.firstEvent = std::min(l.firstEvent, event);
+      l.lastEvent = std::max(l.lastEvent, event);
+      l.nEvents++;
+      l.events.push_back(event);
+   }
+   file.name = name;
+   file.lumis.clear();
+   for (auto &it : lumis) {
+      std::vector<Long64_t> &events = it.second.events;
+      std::sort(events.begin(), events.end());
+      events.erase(std::unique(events.begin(), events.end()), events.end());
+      it.second.nEvents = events.size();
+      file.lumis.push_back(std::move(it.second));
+   }
+   return true;
+}
+
+static int scan(const std::vector<std::string> &inputs, const std::string &output)
+{
+   std::vector<std::string> names;
+   for (const std::string &input : inputs) {
+      if (endsWith(input, ".root")) {
+         names.push_back(input);
+         continue;
+      }
+      std::ifstream catalog(input.c_str());
+      if (!catalog) {
+         std::cerr << "cannot open " << input << std::endl;
+         return 1;
+      }
+      std::string line;
+      while (std::getline(catalog, line))
+         if (!line.empty() && line[0] != '#') names.push_back(line);
+   }
+
+   EventFileLocator locator;
+   std::ifstream existing(output.c_str());
+   if (existing && !locator.read(output)) {
+      std::cerr << locator.error() << std::endl;
+      return 1;
+   }
+   FWLiteEnabler::enable();
+   for (const std::string &name : names) {
+      EventFileLocator::File file;
+      if (!scanFile(name, file)) return 1;
+      locator.add(file);
+   }
+   if (!locator.write(output)) {
+      std::cerr << "failed to write " << output << std::endl;
+      return 1;
+   }
+   return 0;
+}
+
+static int select(const std::string &locatorPath, const std::vector<std::string> &lists, bool json)
+{
+   EventFileLocator locator;
+   if (!locator.read(locatorPath)) {
+      std::cerr << locator.error() << std::endl;
+      return 1;
+   }
+
+   TTree *tree = 0;
+   const bool root = lists.size() == 1 && endsWith(lists[0], ".root");
+   if (root) {
+      TFile *f = TFile::Open(lists[0].c_str());
+      if (f && !f->IsZombie()) f->GetObject("tree", tree);
+      if (!tree) {
+         std::cerr << "no TTree 'tree' in " << lists[0] << std::endl;
+         return 1;
+      }
+   }
+   PickEvents2 pe(tree);
+   bool ok = true;
+   if (root) pe.Loop();
+   else if (lists.size() == 1 && endsWith(lists[0], ".pevl")) ok = pe.LoadBinary(lists[0].c_str());
+   else ok = pe.LoadText(lists);
+   if (!ok || !pe.index) return 1;
+
+   EventFileLocator::writeSelection(std::cout, locator.select(*pe.index), json);
+   return 0;
+}
+
+int main(int argc, char **argv)
+{
+   std::vector<std::string> args;
+   std::string output;
+   bool json = false;
+   for (int i = 2; i < argc; ++i) {
+      if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) output = argv[++i];
+      else if (std::strcmp(argv[i], "--json") == 0) json = true;
+      else args.push_back(argv[i]);
+   }
+   if (argc > 1 && std::strcmp(argv[1], "scan") == 0 && !args.empty() && !output.empty()) return scan(args, output);
+   if (argc > 1 && std::strcmp(argv[1], "select") == 0 && args.size() >= 2)
+      return select(args[0], std::vector<std::string>(args.begin() + 1, args.end()), json);
+
+   std::cerr << "usage: " << argv[0] << " scan <catalog.txt | file.root...> -o locator.txt\n"
+             << "       " << argv[0] << " select locator.txt <list.pevl | list.root | list.txt...> [--json]" << std::endl;
+   return 1;
+}
@@ -0,0 +1,37 @@
+// Writes the lumi sections that hold picked events of a PickEvents2 list,
+// either as a cff fragment defining lumisToProcess for the input source
+// or as a lumi-mask JSON:
+//
+//   pickEventsLumiList UnprefirableEventList_SingleMuon_Run2017BtoF.root > pickedLumis_cff.py
+//   pickEventsLumiList UnprefirableEventList_SingleMuon_Run2017BtoF.root --json > pickedLumis.json
+
+#include "JetMETStudies/JMEAnalyzer/interface/PickEvents2.h"
+#include <TFile.h>
+#include <TTree.h>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char **argv)
+{
+   if (argc < 2) {
+      std::cerr << "usage: " << argv[0] << " <event list .root> [--json]" << std::endl;
+      return 1;
+   }
+   bool json = argc > 2 && std::strcmp(argv[2], "--json") == 0;
+
+   TFile *f = TFile::Open(argv[1]);
+   if (!f || f->IsZombie()) {
+      std::cerr << "cannot open " << argv[1] << std::endl;
+      return 1;
+   }
+   TTree *tree = 0;
+   f->GetObject("tree", tree);
+   if (!tree) {
+      std::cerr << "no TTree 'tree' in " << argv[1] << std::endl;
+      return 1;
+   }
+
+   PickEvents2 pe(tree);
+   pe.writeLumiRanges(std::cout, json);
+   return 0;
+}
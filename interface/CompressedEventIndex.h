@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////
+// Compressed (run,event) lookup backend for very large lists.
+//
+// The sorted events of each run are cut into blocks of kBlockSize.
+// A skip table keeps the first event and the byte offset of every
+// block; the other events are stored as varint-encoded deltas. A
+// lookup binary-searches the runs and the skip table and decodes at
+// most one block, so nothing is ever fully decompressed.
+//
+// Builder fills the index while the list is being read, so that the
+// raw list is never held: see there.
+//////////////////////////////////////////////////////////
+
+#ifndef CompressedEventIndex_h
+#define CompressedEventIndex_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListView.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+class CompressedEventIndex : public EventIndex {
+public :
+   static const size_t kBlockSize = 128;
+
+   CompressedEventIndex() : fN(0) {}
+   explicit CompressedEventIndex(const EventListView &list);
+
+   // appends a run after the last one added: events sorted and unique.
+   // finish() ends the build and must come before any lookup
+   void addRun(Long64_t run, const Long64_t *events, size_t n);
+   void finish();
+
+   // Pairs in any order, one at a time. The pending events of a run are
+   // sorted and encoded into a delta-varint segment once there are
+   // kSegmentEvents of them, and those of every run once kMaxPending are
+   // pending in all. finish() decodes and merges the segments of one run
+   // at a time into the blocks of the index, freeing them as it goes:
+   // memory stays about twice the compressed list plus the largest run.
+   class Builder {
+   public :
+      static const size_t kSegmentEvents = 1 << 16;
+      static const size_t kMaxPending = 1 << 20;
+
+      Builder() : fPending(0), fSegmentBytes(0), fN(0), fPeakBytes(0) {}
+
+      void add(Long64_t run, Long64_t event)
+      {
+         Run &r = fRunsBeingBuilt[run];
+         r.pending.push_back(event);
+         ++fN;
+         if (++fPending >= kMaxPending) flushAll();
+         else if (r.pending.size() >= kSegmentEvents) flush(r);
+      }
+      // takes over what other holds (builders filled in parallel)
+      void merge(Builder &other);
+
+      size_t size() const { return fN; } // pairs added, duplicates included
+      size_t peakBytes() const { return fPeakBytes; }
+
+      // perRun, if set, sees the sorted events of each run before they are encoded
+      std::unique_ptr<CompressedEventIndex>
+      finish(const std::function<void(Long64_t, const Long64_t *, size_t)> &perRun = nullptr);
+
+   private :
+      struct Run {
+         std::vector<Long64_t>                   pending;
+         std::vector<std::vector<unsigned char>> segments; // sorted, unique within a segment
+      };
+
+      void flush(Run &r);
+      void flushAll();
+      void notePeak(size_t extra);
+
+      std::map<Long64_t, Run> fRunsBeingBuilt;
+      size_t                  fPending;
+      size_t                  fSegmentBytes;
+      size_t                  fN;
+      size_t                  fPeakBytes;
+   };
+
+   bool        contains(Long64_t run, Long64_t event) const override;
+   size_t      size() const override { return fN; }
+   size_t      bytes() const override;
+   const char *name() const override { return "compressed"; }
+   void        printStats(std::ostream &os) const override;
+
+private :
+   std::vector<Long64_t>      fRuns;       // sorted
+   std::vector<size_t>        fRunBlock;   // first block of each run, nRuns+1 entries
+   std::vector<Long64_t>      fBlockFirst; // first event of each block
+   std::vector<size_t>        fBlockBytes; // offset of each block in fBytes, nBlocks+1 entries
+   std::vector<unsigned char> fBytes;      // varint deltas after the first event of a block
+   size_t                     fN;
+};
+
+#endif
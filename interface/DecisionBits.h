@@ -0,0 +1,58 @@
+//////////////////////////////////////////////////////////
+// Trigger and filter decisions packed into 64-bit words: one tree
+// branch ("decisionBits", an array of nWords() ULong64_t) instead of
+// one Bool_t branch per decision. Bit i stands for names()[i]; the
+// names are stored once, comma-separated, in a TNamed
+// "decisionBitNames" in the tree's UserInfo.
+//
+// Writing (JMEAnalyzer, PackDecisions = True):
+//   DecisionBits bits(names); bits.attach(tree);
+//   per event: bits.clear(); bits.set(i, pass); ... tree->Fill();
+// Reading:
+//   DecisionBits bits; if (!bits.read(tree)) ...; int b = bits.bit("HLT_IsoMu24");
+//   per entry: tree->GetEntry(i); bits.test(b);
+//////////////////////////////////////////////////////////
+
+#ifndef DecisionBits_h
+#define DecisionBits_h
+
+#include <Rtypes.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+class TTree;
+
+class DecisionBits {
+public :
+   static const char *const kBranchName;   // "decisionBits"
+   static const char *const kMetadataName; // "decisionBitNames"
+
+   DecisionBits() {}
+   explicit DecisionBits(const std::vector<std::string> &names);
+
+   // writer: creates the branch and stores the names in the tree
+   void attach(TTree *tree);
+   void clear() { std::fill(fWords.begin(), fWords.end(), 0ULL); }
+   void set(size_t bit, bool pass)
+   {
+      if (pass) fWords[bit >> 6] |= 1ULL << (bit & 63);
+   }
+
+   // reader: takes the names from the tree and reads the branch into this object; false if absent
+   bool read(TTree *tree);
+   // -1 for a name that is not stored
+   int  bit(const std::string &name) const;
+   bool test(int bit) const { return bit >= 0 && (fWords[bit >> 6] >> (bit & 63)) & 1ULL; }
+   bool test(const std::string &name) const { return test(bit(name)); }
+
+   const std::vector<std::string> &names() const { return fNames; }
+   size_t                          nWords() const { return fWords.size(); }
+   const ULong64_t                *words() const { return fWords.data(); }
+
+private :
+   std::vector<std::string> fNames;
+   std::vector<ULong64_t>   fWords;
+};
+
+#endif
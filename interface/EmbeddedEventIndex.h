@@ -0,0 +1,28 @@
+//////////////////////////////////////////////////////////
+// Lookup backend on a list compiled into the program (see
+// EmbeddedEventList.h): the perfect hash tables live in the read-only
+// data of the library, nothing is built or allocated.
+//////////////////////////////////////////////////////////
+
+#ifndef EmbeddedEventIndex_h
+#define EmbeddedEventIndex_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EmbeddedEventList.h"
+
+class EmbeddedEventIndex : public EventIndex {
+public :
+   explicit EmbeddedEventIndex(const EmbeddedEventList &list) : fList(list) {}
+
+   bool        contains(Long64_t run, Long64_t event) const override { return fList.contains(run, event); }
+   size_t      size() const override { return fList.size(); }
+   size_t      bytes() const override { return 0; }
+   const char *name() const override { return "embedded"; }
+   bool        randomAccess() const override { return true; }
+   void        printStats(std::ostream &os) const override;
+
+private :
+   const EmbeddedEventList &fList;
+};
+
+#endif
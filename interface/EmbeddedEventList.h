@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////
+// Pick list compiled into the program, for small frozen lists.
+//
+// pickEventsEmbed turns a list into a header of constexpr tables: a
+// minimal-ish perfect hash (hash and displace) over the (run,event)
+// pairs. A lookup is one hash, one displacement read and one slot
+// compare, with no branch on the list contents, and can run at compile
+// time (the generated header static_asserts itself). Nothing is read
+// from disk at startup.
+//
+// Including a generated header in one source file of a library
+// registers its list by name: PickEvents2::LoadEmbedded(name) and the
+// PickEventsEmbeddedList parameter of the modules find it there.
+//////////////////////////////////////////////////////////
+
+#ifndef EmbeddedEventList_h
+#define EmbeddedEventList_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+#include <Rtypes.h>
+#include <map>
+#include <string>
+
+struct EmbeddedEvent {
+   Long64_t run;   // -1 in empty slots
+   Long64_t event;
+};
+
+class EmbeddedEventList {
+public :
+   constexpr EmbeddedEventList(const EmbeddedEvent *slots, ULong64_t nSlots, const UInt_t *displacements,
+                               ULong64_t nBuckets, ULong64_t seed, ULong64_t nEvents)
+      : fSlots(slots), fNSlots(nSlots), fDisplacements(displacements), fNBuckets(nBuckets), fSeed(seed),
+        fNEvents(nEvents) {}
+
+   static constexpr ULong64_t hash(Long64_t run, Long64_t event, ULong64_t seed)
+   {
+      return eventHash(eventHash(ULong64_t(run) + seed) ^ ULong64_t(event));
+   }
+   static constexpr ULong64_t bucket(ULong64_t h, ULong64_t nBuckets) { return (h >> 32) % nBuckets; }
+   static constexpr ULong64_t slot(ULong64_t h, UInt_t displacement, ULong64_t nSlots)
+   {
+      return (h ^ eventHash(displacement)) % nSlots;
+   }
+
+   constexpr bool contains(Long64_t run, Long64_t event) const
+   {
+      const ULong64_t h = hash(run, event, fSeed);
+      const EmbeddedEvent &e = fSlots[slot(h, fDisplacements[bucket(h, fNBuckets)], fNSlots)];
+      return e.run == run && e.event == event;
+   }
+
+   constexpr ULong64_t size() const { return fNEvents; }
+   constexpr ULong64_t nSlots() const { return fNSlots; }
+   constexpr ULong64_t nBuckets() const { return fNBuckets; }
+   // slot i, for walking the list (skip run < 0)
+   constexpr const EmbeddedEvent &at(ULong64_t i) const { return fSlots[i]; }
+
+   // lists registered by the generated headers linked in
+   static const EmbeddedEventList *find(const std::string &name)
+   {
+      auto it = registry().find(name);
+      return it == registry().end() ? 0 : it->second;
+   }
+
+   struct Registration {
+      Registration(const char *name, const EmbeddedEventList &list) { registry()[name] = &list; }
+   };
+
+private :
+   static std::map<std::string, const EmbeddedEventList*> &registry()
+   {
+      static std::map<std::string, const EmbeddedEventList*> lists;
+      return lists;
+   }
+
+   const EmbeddedEvent *fSlots;
+   ULong64_t            fNSlots;
+   const UInt_t        *fDisplacements;
+   ULong64_t            fNBuckets;
+   ULong64_t            fSeed;
+   ULong64_t            fNEvents;
+};
+
+#endif
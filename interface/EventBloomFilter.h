@@ -0,0 +1,50 @@
+//////////////////////////////////////////////////////////
+// Cache-line blocked Bloom filter over the (run,event) pairs of a
+// pick list, used by PickEvents2 to reject most events that are not
+// in the list before the exact index is queried.
+//
+// Each key selects one 512-bit block and sets k bits inside it, so a
+// query touches a single cache line. There are no false negatives;
+// the false-positive rate is chosen at construction.
+//////////////////////////////////////////////////////////
+
+#ifndef EventBloomFilter_h
+#define EventBloomFilter_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListView.h"
+#include <vector>
+#include <cstddef>
+
+class EventBloomFilter {
+public :
+   EventBloomFilter(const EventListView &list, double fpr);
+   // sized for n pairs, set by add() run by run as they come
+   EventBloomFilter(size_t n, double fpr);
+
+   // sets the bits of more pairs, on a copy of a filter for a list that
+   // grew. The size stays that of the original list: the rate rises with
+   // the pairs added
+   void add(const EventListView &list);
+   void add(Long64_t run, const Long64_t *events, size_t n);
+
+   bool   mayContain(Long64_t run, Long64_t event) const;
+   double targetFPR() const { return fFPR; }
+   double bitsPerKey() const { return fN ? 512. * fBlocks.size() / fN : 0.; }
+   int    nHashes() const { return fK; }
+   size_t bytes() const { return fBlocks.capacity() * sizeof(Block); }
+
+private :
+   struct alignas(64) Block {
+      ULong64_t w[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+   };
+
+   static ULong64_t keyHash(Long64_t run, Long64_t event);
+
+   std::vector<Block> fBlocks;
+   double             fFPR;
+   int                fK;
+   size_t             fN;
+};
+
+#endif
@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////
+// Which input files hold which events, without opening them again.
+//
+// pickEventsLocate scans the EDM files of a catalog once and stores,
+// per file and (run,lumi), the event numbers it holds. select()
+// intersects that with a pick list and returns the smallest set of
+// files covering the picked events, each with the events to process in
+// it, so a job can skip whole files and jump to the listed events
+// (PoolSource eventsToProcess).
+//
+// On disk, one line per file, one per (run,lumi) of the file and the
+// event numbers of that lumi, as the gaps between consecutive events
+// from the first one (small numbers, a few characters per event):
+//   F <file name>
+//   L <run> <lumi> <first event> <last event> <events>
+//   E <gap> <gap> ...
+//////////////////////////////////////////////////////////
+
+#ifndef EventFileLocator_h
+#define EventFileLocator_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/PickEventsIndex.h"
+#include <Rtypes.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class EventFileLocator {
+public :
+   struct Lumi {
+      Long64_t  run;
+      Long64_t  lumi;
+      Long64_t  firstEvent;
+      Long64_t  lastEvent;
+      ULong64_t nEvents;
+      std::vector<Long64_t> events; // sorted
+   };
+   struct File {
+      std::string       name;
+      std::vector<Lumi> lumis;
+   };
+   struct Event {
+      Long64_t run;
+      Long64_t event;
+      bool operator<(const Event &o) const { return run < o.run || (run == o.run && event < o.event); }
+      bool operator==(const Event &o) const { return run == o.run && event == o.event; }
+   };
+   struct Selection {
+      std::string        file;
+      std::vector<Event> events; // sorted
+   };
+
+   // appends the files of a locator file; false and error set on failure,
+   // including an L line without its E line
+   bool read(const std::string &path);
+   bool write(const std::string &path) const;
+   // a file already present (same name) is replaced
+   void add(const File &file);
+
+   const std::vector<File> &files() const { return fFiles; }
+   const std::string       &error() const { return fError; }
+
+   // greedy minimal cover of the picked events found in the files; needs
+   // the per-run arrays of the list (not the compressed backend)
+   std::vector<Selection> select(const PickEventsIndex &list) const;
+
+   // cff fragment setting fileNames and eventsToProcess, or JSON {file: ["run:event", ...]}
+   static void writeSelection(std::ostream &os, const std::vector<Selection> &selection, bool json = false);
+
+private :
+   std::vector<File> fFiles;
+   std::string       fError;
+};
+
+#endif
@@ -0,0 +1,39 @@
+//////////////////////////////////////////////////////////
+// Common interface of the (run,event) lookup backends that
+// PickEvents2 can build from the pick list.
+//////////////////////////////////////////////////////////
+
+#ifndef EventIndex_h
+#define EventIndex_h
+
+#include <Rtypes.h>
+#include <cstddef>
+#include <ostream>
+
+// murmur3 fmix64, shared by the hashed backends and filters (constexpr for
+// the lists embedded at compile time, see EmbeddedEventList.h)
+constexpr ULong64_t eventHash(ULong64_t h)
+{
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   h *= 0xc4ceb3f99fe15b53ULL;
+   h ^= h >> 33;
+   return h;
+}
+
+class EventIndex {
+public :
+   virtual ~EventIndex() {}
+
+   virtual bool        contains(Long64_t run, Long64_t event) const = 0;
+   virtual size_t      size() const = 0;   // number of distinct (run,event) pairs
+   virtual size_t      bytes() const = 0;  // heap memory held by the index
+   virtual const char *name() const = 0;
+   // lookups cost the same in any order (no point sorting a batch first)
+   virtual bool        randomAccess() const { return false; }
+   // backend specific statistics, one "key: value" per line
+   virtual void        printStats(std::ostream &os) const;
+};
+
+#endif
@@ -0,0 +1,117 @@
+//////////////////////////////////////////////////////////
+// Binary pick-list format, meant to be mmap'ed read-only.
+//
+//   header     EventListFileHeader (fixed size)
+//   events     Long64_t[nEvents], grouped by run, sorted and unique
+//   run table  EventListRunEntry[nRuns], sorted by run
+//   lumi table EventListLumiEntry[nLumis], sorted by packed (run,lumi)
+//
+// The tables follow the events so that a writer can stream the
+// events out run by run and only keeps the small tables in memory.
+// The checksum covers everything after the header; sourceChecksum
+// records the file the list was built from, for the builder cache.
+//////////////////////////////////////////////////////////
+
+#ifndef EventListFile_h
+#define EventListFile_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventListView.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct EventListFileHeader {
+   char      magic[8];        // "PEVLIST"
+   UInt_t    version;
+   UInt_t    headerSize;
+   ULong64_t nRuns;
+   ULong64_t nEvents;
+   ULong64_t nLumis;
+   ULong64_t eventsOffset;
+   ULong64_t runTableOffset;
+   ULong64_t lumiTableOffset;
+   ULong64_t checksum;
+   ULong64_t sourceChecksum;
+   ULong64_t reserved[4];
+};
+
+struct EventListRunEntry {
+   Long64_t  run;
+   ULong64_t first; // index of the first event of the run
+   ULong64_t count;
+};
+
+struct EventListLumiEntry {
+   ULong64_t key;   // LumiIndex::pack(run, lumi)
+   ULong64_t count;
+};
+
+static const char   kEventListMagic[8] = "PEVLIST";
+static const UInt_t kEventListVersion = 1;
+
+// 64-bit checksum over 8-byte words; a zero-padded tail word is used
+// when nbytes is not a multiple of 8. Chaining calls gives the same
+// result as one call as long as every chunk but the last is 8-aligned.
+ULong64_t eventListChecksum(const void *data, size_t nbytes, ULong64_t h = 0);
+// checksum of a whole file, 0 if it cannot be read
+ULong64_t eventListFileChecksum(const std::string &path);
+
+class EventListWriter {
+public :
+   explicit EventListWriter(const std::string &path);
+   ~EventListWriter();
+
+   bool good() const { return fFile != 0; }
+   // runs must come in increasing order, events sorted and unique. Calling
+   // it again for the last run appends to it, so a run can be streamed out
+   // in pieces.
+   void addRun(Long64_t run, const Long64_t *events, size_t n);
+   void addLumi(ULong64_t key, ULong64_t count) { fLumis.push_back(EventListLumiEntry{key, count}); }
+   void addList(const EventListView &list);
+   // writes the tables and the header; false on any I/O error
+   bool close(ULong64_t sourceChecksum = 0);
+
+private :
+   FILE                           *fFile;
+   EventListFileHeader             fHeader;
+   std::vector<EventListRunEntry>  fRuns;
+   std::vector<EventListLumiEntry> fLumis;
+   ULong64_t                       fChecksum;
+   bool                            fOk;
+};
+
+class MappedEventList : public EventListView {
+public :
+   MappedEventList();
+   ~MappedEventList();
+
+   // maps the file read-only; verify also recomputes the checksum
+   bool open(const std::string &path, bool verify = false);
+   const std::string &error() const { return fError; }
+
+   size_t          nRuns() const override { return fHeader ? fHeader->nRuns : 0; }
+   Long64_t        run(size_t i) const override { return fRunTable[i].run; }
+   size_t          nEvents(size_t i) const override { return fRunTable[i].count; }
+   const Long64_t *events(size_t i) const override { return fEvents + fRunTable[i].first; }
+   size_t          findRun(Long64_t run) const override;
+
+   size_t                    nLumis() const { return fHeader ? fHeader->nLumis : 0; }
+   const EventListLumiEntry *lumis() const { return fLumiTable; }
+   const EventListFileHeader *header() const { return fHeader; }
+   size_t                    mappedBytes() const { return fSize; }
+   // for a reader that streams through the whole file instead of looking up
+   void                      adviseSequential();
+
+private :
+   void close();
+
+   void                      *fMap;
+   size_t                     fSize;
+   const EventListFileHeader *fHeader;
+   const Long64_t            *fEvents;
+   const EventListRunEntry   *fRunTable;
+   const EventListLumiEntry  *fLumiTable;
+   std::string                fError;
+};
+
+#endif
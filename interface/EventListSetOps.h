@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////
+// Union, intersection and difference of any number of event lists
+// in one streaming pass.
+//
+// A source yields its (run,event) pairs in increasing order without
+// duplicates; mergeEventLists walks N sources together (k-way merge
+// on a heap) and hands every pair of the result to a sink, so memory
+// does not grow with the size of the lists. Binary lists are read
+// mapped. Lists in any other order go through SortedSpill first: it
+// sorts fixed-size chunks, spills them to temporary binary lists and
+// serves them back as the union of those, i.e. an external merge sort.
+//
+// Only (run,event) pairs are combined: results carry no lumi table.
+//////////////////////////////////////////////////////////
+
+#ifndef EventListSetOps_h
+#define EventListSetOps_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+#include <Rtypes.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+
+class EventListSource {
+public :
+   virtual ~EventListSource() {}
+   // next pair in (run,event) order; false at the end
+   virtual bool next(Long64_t &run, Long64_t &event) = 0;
+};
+
+// a binary list file, mapped
+class MappedEventListSource : public EventListSource {
+public :
+   bool open(const std::string &path);
+   const std::string &error() const { return fList.error(); }
+   bool next(Long64_t &run, Long64_t &event) override;
+
+private :
+   MappedEventList fList;
+   size_t          fRun;
+   size_t          fPos;
+};
+
+enum EventListSetOp {
+   kEventListUnion,        // in any source
+   kEventListIntersection, // in every source
+   kEventListDifference    // in the first source and in none of the others
+};
+
+class EventListSink {
+public :
+   virtual ~EventListSink() {}
+   virtual void add(Long64_t run, Long64_t event) = 0;
+   // false on any I/O error
+   virtual bool close() = 0;
+};
+
+// binary list (EventListFile.h), streamed out in blocks
+class BinaryEventListSink : public EventListSink {
+public :
+   explicit BinaryEventListSink(const std::string &path) : fWriter(path), fRun(0) {}
+   bool good() const { return fWriter.good(); }
+   void add(Long64_t run, Long64_t event) override;
+   bool close() override;
+
+private :
+   void flush();
+
+   EventListWriter       fWriter;
+   Long64_t              fRun;
+   std::vector<Long64_t> fEvents;
+};
+
+// one "run event" per line, readable by TextEventList
+class TextEventListSink : public EventListSink {
+public :
+   explicit TextEventListSink(const std::string &path) : fOut(path.c_str()) {}
+   bool good() const { return bool(fOut); }
+   void add(Long64_t run, Long64_t event) override { fOut << run << ' ' << event << '\n'; }
+   bool close() override;
+
+private :
+   std::ofstream fOut;
+};
+
+// TTree "tree" with run/event/lumi branches like the PickEvents2 input (lumi = -1)
+class RootEventListSink : public EventListSink {
+public :
+   explicit RootEventListSink(const std::string &path);
+   ~RootEventListSink();
+   bool good() const { return fTree != 0; }
+   void add(Long64_t run, Long64_t event) override;
+   bool close() override;
+
+private :
+   TFile   *fFile;
+   TTree   *fTree;
+   Long64_t fRun, fEvent, fLumi;
+};
+
+// External sort of pairs given in any order, duplicates allowed.
+class SortedSpill {
+public :
+   // chunkSize pairs are kept in memory before a chunk is spilled to tmpDir
+   explicit SortedSpill(const std::string &tmpDir, size_t chunkSize = 1 << 23);
+
+   void add(Long64_t run, Long64_t event);
+   // ends the input; the source stays valid while the spill object lives.
+   // Null and error set if a chunk could not be written.
+   EventListSource   *finish();
+   const std::string &error() const { return fError; }
+
+private :
+   struct Pair {
+      Long64_t run;
+      Long64_t event;
+      bool operator<(const Pair &o) const { return run < o.run || (run == o.run && event < o.event); }
+      bool operator==(const Pair &o) const { return run == o.run && event == o.event; }
+   };
+   bool spill();
+
+   std::string                                         fTmpDir;
+   size_t                                              fChunkSize;
+   std::vector<Pair>                                   fBuffer;
+   std::vector<std::unique_ptr<MappedEventListSource>> fChunks;
+   std::unique_ptr<EventListSource>                    fSource;
+   std::string                                         fError;
+};
+
+// Streams op(sources) into sink (which is not closed); returns the pairs written.
+ULong64_t mergeEventLists(const std::vector<EventListSource*> &sources, EventListSetOp op, EventListSink &sink);
+
+#endif
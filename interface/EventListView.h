@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////
+// Read-only view of a pick list grouped by run: runs in increasing
+// order, the events of each run sorted and unique in one contiguous
+// array. The lookup backends and filters are built from a view, so
+// they do not care whether the list was read from the ROOT tree into
+// memory or mapped from a binary list file.
+//////////////////////////////////////////////////////////
+
+#ifndef EventListView_h
+#define EventListView_h
+
+#include <Rtypes.h>
+#include <map>
+#include <vector>
+#include <cstddef>
+
+class EventListView {
+public :
+   virtual ~EventListView() {}
+
+   virtual size_t          nRuns() const = 0;
+   virtual Long64_t        run(size_t i) const = 0;
+   virtual size_t          nEvents(size_t i) const = 0;
+   virtual const Long64_t *events(size_t i) const = 0;
+
+   // position of the run, or nRuns() if it is not in the list
+   virtual size_t findRun(Long64_t run) const;
+   size_t         totalEvents() const;
+};
+
+// View on the run -> sorted events map filled by PickEvents2::Loop
+class MapEventListView : public EventListView {
+public :
+   explicit MapEventListView(const std::map<Long64_t, std::vector<Long64_t>> &run_to_event_map);
+
+   size_t          nRuns() const override { return fRuns.size(); }
+   Long64_t        run(size_t i) const override { return fRuns[i]; }
+   size_t          nEvents(size_t i) const override { return fEvents[i]->size(); }
+   const Long64_t *events(size_t i) const override { return fEvents[i]->data(); }
+
+private :
+   std::vector<Long64_t>                     fRuns;
+   std::vector<const std::vector<Long64_t>*> fEvents;
+};
+
+// base with the runs of replaced swapped in (or added): those point at
+// the arrays of replaced, all other runs at the arrays of base, which
+// must outlive the view
+class OverlayEventListView : public EventListView {
+public :
+   OverlayEventListView(const EventListView &base, const std::map<Long64_t, std::vector<Long64_t>> &replaced);
+
+   size_t          nRuns() const override { return fRuns.size(); }
+   Long64_t        run(size_t i) const override { return fRuns[i]; }
+   size_t          nEvents(size_t i) const override { return fNEvents[i]; }
+   const Long64_t *events(size_t i) const override { return fEvents[i]; }
+
+private :
+   std::vector<Long64_t>        fRuns;
+   std::vector<const Long64_t*> fEvents;
+   std::vector<size_t>          fNEvents;
+};
+
+#endif
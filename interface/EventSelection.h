@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////
+// One predicate over (run, lumi, event) combining any mix of exact
+// pick lists (through their PickEvents2 handles), lumi masks and event
+// ranges (IntervalMask), each either required or vetoed.
+//
+// compile() orders the terms cheapest first: lumi masks, whose answer
+// is kept for the current lumi section so that they cost one compare
+// per event of a lumi, then event ranges, then exact lists. accept()
+// stops at the first term that rejects the event and counts it there.
+//
+// Holds per-handle state (the lumi memo, the lists' cursors): one
+// EventSelection per stream, like PickEvents2.
+//////////////////////////////////////////////////////////
+
+#ifndef EventSelection_h
+#define EventSelection_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/IntervalMask.h"
+#include <Rtypes.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+class PickEvents2;
+
+class EventSelection {
+public :
+   enum Kind { kLumiMask, kEventRanges, kList };
+
+   EventSelection() : nEvents(0), nAccepted(0), fCompiled(true) {}
+
+   // veto: the term rejects the events it holds instead of the others
+   void addList(PickEvents2 *list, bool veto, const std::string &name);
+   void addLumiMask(std::shared_ptr<const IntervalMask> mask, bool veto, const std::string &name);
+   void addEventRanges(std::shared_ptr<const IntervalMask> ranges, bool veto, const std::string &name);
+   // orders the terms; done by the first accept() if not called
+   void compile();
+
+   bool accept(Long64_t run, Long64_t lumi, Long64_t event)
+   {
+      if (!fCompiled) compile();
+      nEvents++;
+      for (Term &t : fTerms) {
+         if (t.test(run, lumi, event) == t.veto) {
+            t.nRejected++;
+            return false;
+         }
+      }
+      nAccepted++;
+      return true;
+   }
+
+   size_t size() const { return fTerms.size(); }
+   // terms in evaluation order with the events each rejected
+   void printStats(std::ostream &os = std::cout) const;
+
+   ULong64_t nEvents;
+   ULong64_t nAccepted;
+
+private :
+   struct Term {
+      Kind                                kind;
+      bool                                veto;
+      std::string                         name;
+      std::shared_ptr<const IntervalMask> mask;
+      PickEvents2                        *list;
+      ULong64_t                           nRejected;
+      Long64_t                            lastRun; // lumi memo
+      Long64_t                            lastLumi;
+      bool                                lastIn;
+
+      bool test(Long64_t run, Long64_t lumi, Long64_t event);
+   };
+
+   void add(Term t);
+
+   std::vector<Term> fTerms;
+   bool              fCompiled;
+};
+
+#endif
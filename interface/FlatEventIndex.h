@@ -0,0 +1,43 @@
+//////////////////////////////////////////////////////////
+// Immutable (run,event) index used by PickEvents2::match.
+//
+// Every (run,event) pair of the pick list is packed into a single
+// 128-bit key (run in the high word, event in the low word). The
+// sorted, de-duplicated keys are stored in one contiguous array laid
+// out in Eytzinger (BFS) order, so a lookup is a branch-free descent
+// of ~log2(n) steps with no allocation and no pointer chasing.
+//////////////////////////////////////////////////////////
+
+#ifndef FlatEventIndex_h
+#define FlatEventIndex_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListView.h"
+#include <vector>
+#include <cstddef>
+
+class FlatEventIndex : public EventIndex {
+public :
+   typedef unsigned __int128 Key;
+
+   FlatEventIndex();
+   explicit FlatEventIndex(const EventListView &list);
+
+   static Key pack(Long64_t run, Long64_t event)
+   {
+      return (Key((ULong64_t)run) << 64) | Key((ULong64_t)event);
+   }
+
+   bool        contains(Long64_t run, Long64_t event) const override;
+   size_t      size() const override { return fN; }
+   size_t      bytes() const override { return fKeys.capacity() * sizeof(Key); }
+   const char *name() const override { return "sorted"; }
+
+private :
+   size_t fill(const std::vector<Key> &sorted, size_t i, size_t k);
+
+   std::vector<Key> fKeys; // Eytzinger order, 1-based (fKeys[0] is unused)
+   size_t           fN;
+};
+
+#endif
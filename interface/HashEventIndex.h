@@ -0,0 +1,56 @@
+//////////////////////////////////////////////////////////
+// Hash based (run,event) lookup backend.
+//
+// One open-addressing table with linear probing is built per run,
+// all of them packed into a single slot array. A small open-addressing
+// run directory gives the table of a run, so a membership check costs
+// one probe in the directory plus ~1 probe in the run table whatever
+// the list size.
+//////////////////////////////////////////////////////////
+
+#ifndef HashEventIndex_h
+#define HashEventIndex_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListView.h"
+#include <vector>
+#include <cstddef>
+
+class HashEventIndex : public EventIndex {
+public :
+   HashEventIndex();
+   explicit HashEventIndex(const EventListView &list);
+
+   bool        contains(Long64_t run, Long64_t event) const override;
+   size_t      size() const override { return fN; }
+   size_t      bytes() const override;
+   const char *name() const override { return "hash"; }
+   bool        randomAccess() const override { return true; }
+   void        printStats(std::ostream &os) const override;
+
+   double loadFactor() const { return fSlots.empty() ? 0. : double(fN) / fSlots.size(); }
+   double meanProbeLength() const { return fN ? double(fProbeSum) / fN : 0.; }
+   size_t maxProbeLength() const { return fProbeMax; }
+
+   static ULong64_t hash(Long64_t x) { return eventHash((ULong64_t)x); }
+
+private :
+   struct RunSlot {
+      Long64_t run;    // kEmpty if the directory slot is free
+      size_t   offset; // first slot of the run table in fSlots
+      size_t   mask;   // run table capacity - 1
+   };
+
+   static constexpr Long64_t kEmpty = -1; // run and event numbers are never negative
+
+   const RunSlot *findRun(Long64_t run) const;
+
+   std::vector<RunSlot>  fRuns;
+   std::vector<Long64_t> fSlots;
+   size_t                fNRuns;
+   size_t                fN;
+   size_t                fProbeSum;
+   size_t                fProbeMax;
+};
+
+#endif
@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////
+// Set of closed intervals of (run, value) points, value being a lumi
+// section or an event number: a certified-lumi JSON mask, or event
+// ranges as given to the input source ("run:event-run:event").
+//
+// Intervals are kept sorted and merged, so contains() is one binary
+// search over the interval starts. An interval may span runs
+// ("1:100-3:50" holds every event of run 2).
+//////////////////////////////////////////////////////////
+
+#ifndef IntervalMask_h
+#define IntervalMask_h
+
+#include <Rtypes.h>
+#include <string>
+#include <vector>
+
+class IntervalMask {
+public :
+   struct Point {
+      Long64_t run;
+      Long64_t value; // lumi or event
+   };
+   struct Interval {
+      Point first; // both ends included
+      Point last;
+   };
+
+   IntervalMask() {}
+   // sorted and merged
+   explicit IntervalMask(std::vector<Interval> intervals);
+
+   // lumi-mask JSON: {"run": [[firstLumi, lastLumi], ...], ...}; added to the intervals held
+   bool loadLumiJson(const std::string &path);
+   bool parseLumiJson(const std::string &text);
+   // "run:event", "run:event-run:event", or "run" for the whole run
+   bool addRanges(const std::vector<std::string> &ranges);
+
+   bool contains(Long64_t run, Long64_t value) const;
+   // any value of the run in the set
+   bool hasRun(Long64_t run) const;
+   size_t          size() const { return fIntervals.size(); }
+   const Interval &interval(size_t i) const { return fIntervals[i]; }
+   const std::string &error() const { return fError; }
+
+   static const Long64_t kMaxValue = 0x7fffffffffffffffLL;
+
+private :
+   void add(std::vector<Interval> intervals);
+
+   std::vector<Interval> fIntervals; // sorted by first, disjoint
+   std::string           fError;
+};
+
+inline bool operator<(const IntervalMask::Point &a, const IntervalMask::Point &b)
+{
+   return a.run < b.run || (a.run == b.run && a.value < b.value);
+}
+
+#endif
@@ -0,0 +1,86 @@
+//////////////////////////////////////////////////////////
+// Pick list read from the ROOT tree one run at a time.
+//
+// open() gets the run -> entry-range index of the list tree: read
+// from the cache directory if an index for the same files (path,
+// size, mtime) is there, else built by reading the run column alone
+// and written there for the next jobs. events(run) then reads the
+// event column of that run's entries only, the first time the run is
+// asked for, so memory and startup follow the runs a job processes
+// rather than the size of the list.
+//
+// One object serves every PickEvents2 handle on the same files
+// (shared()); events() may be called from any thread, a run being
+// read once under a lock. The arrays returned never move.
+//
+// On disk (<cache>/pickevents_runs_<key>.peri):
+//   "PERI" | UInt_t version | ULong64_t n | n x {run, first, last}
+//   (Long64_t, entries [first, last) of the chain)
+//////////////////////////////////////////////////////////
+
+#ifndef LazyEventList_h
+#define LazyEventList_h
+
+#include <Rtypes.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class TChain;
+
+class LazyEventList {
+public :
+   struct Range {
+      Long64_t first; // entries [first, last)
+      Long64_t last;
+   };
+
+   // cacheDir empty: $PICKEVENTS_CACHE, else /tmp
+   LazyEventList(const std::vector<std::string> &files, const std::string &treeName, const std::string &cacheDir);
+   ~LazyEventList();
+
+   // reads or builds the run index; false and error set on failure
+   bool open();
+   // the one object opened for these files and tree, null on failure
+   static std::shared_ptr<LazyEventList> shared(const std::vector<std::string> &files, const std::string &treeName,
+                                                const std::string &cacheDir = "");
+
+   // sorted, unique events of the run, read on first use; null if the run is not in the list
+   const std::vector<Long64_t> *events(Long64_t run);
+   bool   hasRun(Long64_t run) const { return fRanges.count(run) > 0; }
+   size_t nRuns() const { return fRanges.size(); }
+
+   size_t      nRunsLoaded() const;
+   ULong64_t   entriesRead() const;  // by events(), over all runs
+   Long64_t    bytesRead() const;    // by events(), over all runs
+   double      indexSeconds() const { return fIndexSeconds; }
+   bool        indexFromCache() const { return fIndexFromCache; }
+   Long64_t    entries() const { return fEntries; }
+   const std::string &error() const { return fError; }
+
+private :
+   std::string indexPath() const;
+   bool        readIndex(const std::string &path);
+   bool        writeIndex(const std::string &path) const;
+   bool        buildIndex();
+
+   std::vector<std::string>               fFiles;
+   std::string                            fTreeName;
+   std::string                            fCacheDir;
+   std::map<Long64_t, std::vector<Range>> fRanges; // fixed once open() returns
+   Long64_t                               fEntries;
+   double                                 fIndexSeconds;
+   bool                                   fIndexFromCache;
+   std::string                            fError;
+
+   mutable std::mutex                        fMutex; // guards everything below
+   std::unique_ptr<TChain>                   fChain;
+   Long64_t                                  fEvent;
+   std::map<Long64_t, std::vector<Long64_t>> fLoaded; // map nodes never move
+   ULong64_t                                 fEntriesRead;
+   Long64_t                                  fBytesRead;
+};
+
+#endif
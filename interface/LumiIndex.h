@@ -0,0 +1,53 @@
+//////////////////////////////////////////////////////////
+// (run,lumi) -> number of picked events, built by PickEvents2 from
+// the lumi branch of the list tree. Lets a job tell which lumi
+// sections hold no picked event at all and emit the lumi ranges
+// that do, to be fed to the input source (lumisToProcess).
+//////////////////////////////////////////////////////////
+
+#ifndef LumiIndex_h
+#define LumiIndex_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+class LumiIndex {
+public :
+   struct Range {
+      Long64_t run;
+      Long64_t firstLumi;
+      Long64_t lastLumi;
+   };
+
+   LumiIndex() {}
+   // one packed (run,lumi) key per picked event, in any order
+   explicit LumiIndex(std::vector<ULong64_t> keys);
+   // base with one more event for each of keys
+   LumiIndex(const LumiIndex &base, std::vector<ULong64_t> keys);
+   // (key, count) table of a binary list file, sorted by key
+   LumiIndex(const EventListLumiEntry *table, size_t n);
+
+   static ULong64_t pack(Long64_t run, Long64_t lumi)
+   {
+      return ((ULong64_t)run << 32) | ((ULong64_t)lumi & 0xffffffffULL);
+   }
+
+   ULong64_t eventCount(Long64_t run, Long64_t lumi) const;
+   bool      hasEvents(Long64_t run, Long64_t lumi) const { return eventCount(run, lumi) > 0; }
+   size_t    size() const { return fKeys.size(); } // lumi sections with picked events
+   ULong64_t key(size_t i) const { return fKeys[i]; }
+   ULong64_t count(size_t i) const { return fCounts[i]; }
+
+   // consecutive lumis with picked events merged into ranges
+   std::vector<Range> ranges() const;
+   // cff fragment defining lumisToProcess, or a CMS lumi-mask JSON
+   void writeRanges(std::ostream &os, bool json = false) const;
+
+private :
+   std::vector<ULong64_t> fKeys;   // sorted, unique
+   std::vector<ULong64_t> fCounts; // picked events per key
+};
+
+#endif
@@ -0,0 +1,29 @@
+//////////////////////////////////////////////////////////
+// Sorted lookup backend working in place on a mapped binary list
+// file: a binary search in the run table, then one in the sorted
+// event block of the run. Nothing is copied to the heap, so the
+// index is ready as soon as the file is mapped.
+//////////////////////////////////////////////////////////
+
+#ifndef MappedEventIndex_h
+#define MappedEventIndex_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+
+class MappedEventIndex : public EventIndex {
+public :
+   // the list must outlive the index
+   explicit MappedEventIndex(const MappedEventList &list) : fList(list) {}
+
+   bool        contains(Long64_t run, Long64_t event) const override;
+   size_t      size() const override { return fList.header() ? fList.header()->nEvents : 0; }
+   size_t      bytes() const override { return 0; }
+   const char *name() const override { return "mapped"; }
+   void        printStats(std::ostream &os) const override;
+
+private :
+   const MappedEventList &fList;
+};
+
+#endif
@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////
+// Lookup backend of a list that grew (PickEventsIndex::appended): the
+// index of the list it grew from, shared and left as it is, plus a
+// small index over the events added since. Lists only grow, so a pair
+// is in the list if either index holds it. The added index is asked
+// first: it is small, and for a run it does not hold the answer is
+// one probe.
+//////////////////////////////////////////////////////////
+
+#ifndef OverlayEventIndex_h
+#define OverlayEventIndex_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+#include <memory>
+
+class OverlayEventIndex : public EventIndex {
+public :
+   // base must outlive the overlay; added holds no pair of base
+   OverlayEventIndex(const EventIndex &base, std::unique_ptr<EventIndex> added)
+      : fBase(base), fAdded(std::move(added)) {}
+
+   bool contains(Long64_t run, Long64_t event) const override
+   {
+      return fAdded->contains(run, event) || fBase.contains(run, event);
+   }
+   size_t      size() const override { return fBase.size() + fAdded->size(); }
+   size_t      bytes() const override { return fBase.bytes() + fAdded->bytes(); }
+   const char *name() const override { return fBase.name(); }
+   bool        randomAccess() const override { return fBase.randomAccess() && fAdded->randomAccess(); }
+   void        printStats(std::ostream &os) const override;
+
+   const EventIndex &base() const { return fBase; }
+   const EventIndex &added() const { return *fAdded; }
+
+private :
+   const EventIndex           &fBase;
+   std::unique_ptr<EventIndex> fAdded;
+};
+
+#endif
@@ -11,15 +11,30 @@
 #include <TROOT.h>
 #include <TChain.h>
 #include <vector>
+#include <string>
+#include <algorithm>
 #include <map>
+#include <set>
 #include <assert.h>
 #include <TFile.h>
 #include <TMath.h>
+#include <iostream>
+#include "JetMETStudies/JMEAnalyzer/interface/RunCursor.h"
+#include "JetMETStudies/JMEAnalyzer/interface/PickEventsIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/PickEventsReloader.h"
+#include "JetMETStudies/JMEAnalyzer/interface/LazyEventList.h"
 
 // Header file for the classes stored in the TTree if any.
 
 class PickEvents2 {
 public :
+   // lookup structure built from the list by Loop()
+   enum IndexBackend {
+      kSorted = PickEventsIndex::kSorted,
+      kHash = PickEventsIndex::kHash,
+      kCompressed = PickEventsIndex::kCompressed
+   };
+
    TTree          *fChain;   //!pointer to the analyzed TTree or TChain
    Int_t           fCurrent; //!current Tree number in a TChain
 
@@ -28,46 +43,137 @@ public :
    // Declaration of leaf types
    Long64_t        event;
    Long64_t        run;
-   //Long64_t        lumi;
+   Long64_t        lumi;
    //Int_t           nvtx;
 
    // List of branches
    TBranch        *b_event;   //!
    TBranch        *b_run;   //!
-   //TBranch        *b_lumi;   //!
+   TBranch        *b_lumi;   //!
    //TBranch        *b_nvtx;   //!
 
-   PickEvents2(TTree *tree=0);
+   // PickEventsIndex::backendFromName for the IndexBackend values
+   static bool backendFromName(const std::string &name, IndexBackend &backend);
+
+   // prefilterFPR > 0 puts a Bloom filter with that false-positive rate in front of the index
+   PickEvents2(TTree *tree=0, IndexBackend backend=kSorted, double prefilterFPR=0);
    virtual ~PickEvents2();
    virtual Int_t    Cut(Long64_t entry);
    virtual Int_t    GetEntry(Long64_t entry);
    virtual Long64_t LoadTree(Long64_t entry);
    virtual void     Init(TTree *tree);
+   // connects the tree of the file used to generate this class
+   void             OpenDefaultList();
    //virtual std::map<Long64_t, std::vector<Long64_t>>     Loop();
+   // builds (or picks up from the process-wide cache) the index of the tree.
+   // One of Loop, LoadBinary or LoadText must run before match().
    virtual void Loop();
+   // read only the run/event/lumi columns, serially or on nLoadThreads tasks
+   // over cluster ranges; return the bytes read
+   virtual Long64_t LoadColumns(std::vector<Long64_t> &runs, std::vector<Long64_t> &events, std::vector<Long64_t> &lumis);
+   virtual Long64_t LoadColumnsMT(std::vector<Long64_t> &runs, std::vector<Long64_t> &events, std::vector<Long64_t> &lumis);
+   // the same columns fed straight into a compressed index, holding none of them
+   virtual Long64_t LoadStream(PickEventsIndex::Stream &stream);
 // virtual bool bsearch(std::vector<Long64_t> &v, Long64_t value); 
  virtual Bool_t   Notify();
  
    virtual void     Show(Long64_t entry = -1);
+   // only reads the shared index: one PickEvents2 per stream can match
+   // concurrently, the cursor and counters below are per instance
    virtual bool match(Long64_t sample_run, Long64_t sample_event);
-   bool first;
+   // bulk tagging: bit i of mask is set if (runs[i],events[i]) is picked,
+   // see PickEventsIndex::matchBatch
+   virtual void matchBatch(const Long64_t *runs, const Long64_t *events, size_t n, std::vector<ULong64_t> &mask);
+   void matchBatch(const std::vector<Long64_t> &runs, const std::vector<Long64_t> &events, std::vector<ULong64_t> &mask)
+   {
+      matchBatch(runs.data(), events.data(), std::min(runs.size(), events.size()), mask);
+   }
+   // selection counters and index summary: a table, or one JSON object
+   virtual void printStats(std::ostream &os = std::cout) const;
+   virtual void writeStatsJson(std::ostream &os) const;
+   // lumi-section level view of the list, see LumiIndex
+   virtual bool lumiHasEvents(Long64_t sample_run, Long64_t sample_lumi);
+   virtual ULong64_t lumiEventCount(Long64_t sample_run, Long64_t sample_lumi);
+   virtual void writeLumiRanges(std::ostream &os, bool json = false);
+   // binary list file (see EventListFile.h): map it instead of reading the tree,
+   // or write the loaded list to it
+   virtual bool LoadBinary(const char *path, bool verify = false);
+   virtual bool WriteBinary(const char *path, ULong64_t sourceChecksum = 0);
+   // text lists (PickEvents3 format, see TextEventList.h) instead of the tree
+   virtual bool LoadText(const std::vector<std::string> &files);
+   // list compiled in by a header from pickEventsEmbed (see EmbeddedEventList.h)
+   virtual bool LoadEmbedded(const std::string &name);
+   // lazy mode (see LazyEventList): instead of Loop, index the tree by run and
+   // read the events of a run at the first match() in it. Lookups go through
+   // the run cursor; lumi queries need the full index (Loop).
+   virtual bool LoadLazy(const std::string &cacheDir = "");
+   // follow the list files while the job runs (see PickEventsReloader): the
+   // index is rebuilt or appended to in the background and picked up by the
+   // next lookup. No files: the files of the tree. Replaces any index loaded.
+   virtual bool Watch(const std::vector<std::string> &files, double pollSeconds);
+   PickEventsIndex::Options indexOptions() const;
+   std::shared_ptr<const PickEventsIndex> index; // immutable, shared by all handles on the same list
+   IndexBackend backend;
+   double prefilterFPR;
+   ULong64_t nPrefilterRejected;       // negatives stopped by the Bloom filter
+   ULong64_t nPrefilterFalsePositives; // filter passes that the index rejected
+   // run-scoped mode: pin the current run's events and gallop from the last
+   // lookup instead of searching the whole index (for run-ordered input)
+   bool runScoped;
+   RunCursor cursor;
+   ULong64_t nRunSwitches;
+   // threads used by Loop to read and sort the list (<= 1: serial)
+   UInt_t nLoadThreads;
+   ULong64_t nBatchLookups; // pairs tested by matchBatch
+   double batchSeconds;
+   std::shared_ptr<PickEventsReloader> reloader; // set by Watch
+   std::shared_ptr<LazyEventList> lazy;          // set by LoadLazy, instead of index
+   ULong64_t reloadGeneration;                   // of the index held, see refresh()
+   ULong64_t nReloads;                           // new indexes picked up
+   // match() telemetry, per handle (i.e. per stream)
+   ULong64_t nLookups;
+   ULong64_t nHits;
+   double matchSeconds;                  // estimated from one lookup in kTimingStride
+   std::set<Long64_t> runsNotInList;     // input runs with no event in the list
+   Long64_t lastRun;
+   static const ULong64_t kTimingStride = 16;
+
+private :
+   bool lookup(Long64_t sample_run, Long64_t sample_event);
+   // swaps in the reloader's latest index, if there is a newer one
+   void refresh()
+   {
+      if (!reloader || reloader->generation() == reloadGeneration) return;
+      reloadGeneration = reloader->generation();
+      index = reloader->current();
+      cursor.reset();
+      nReloads++;
+   }
 };
 
 #endif
 
 #ifdef PickEvents2_cxx
-PickEvents2::PickEvents2(TTree *tree) : fChain(0), first(true) 
+PickEvents2::PickEvents2(TTree *tree, IndexBackend backend, double prefilterFPR)
+   : fChain(0), fCurrent(-1), backend(backend), prefilterFPR(prefilterFPR),
+     nPrefilterRejected(0), nPrefilterFalsePositives(0), runScoped(false), nRunSwitches(0),
+     nLoadThreads(0), nBatchLookups(0), batchSeconds(0), reloadGeneration(0), nReloads(0),
+     nLookups(0), nHits(0), matchSeconds(0), lastRun(-1)
 {
-// if parameter tree is not specified (or zero), connect the file
-// used to generate this class and read the Tree.
-   if (tree == 0) {
-      TFile *f = (TFile*)gROOT->GetListOfFiles()->FindObject("JetMETStudies/JMEAnalyzer/python/UnprefirableEventList_SingleMuon_Run2017BtoF.root");
-      if (!f || !f->IsOpen()) {
-         f = new TFile("UnprefirableEventList_SingleMuon_Run2017BtoF.root");
-      }
-      f->GetObject("tree",tree);
+// if parameter tree is not specified (or zero), the file used to generate
+// this class is connected by the first Loop() (OpenDefaultList), so that
+// binary, text and embedded lists do no ROOT I/O at all
+   Init(tree);
+}
 
+void PickEvents2::OpenDefaultList()
+{
+   TTree *tree = 0;
+   TFile *f = (TFile*)gROOT->GetListOfFiles()->FindObject("JetMETStudies/JMEAnalyzer/python/UnprefirableEventList_SingleMuon_Run2017BtoF.root");
+   if (!f || !f->IsOpen()) {
+      f = new TFile("UnprefirableEventList_SingleMuon_Run2017BtoF.root");
    }
+   f->GetObject("tree",tree);
    Init(tree);
 }
 
@@ -114,7 +220,7 @@ void PickEvents2::Init(TTree *tree)
 
    fChain->SetBranchAddress("event", &event, &b_event);
    fChain->SetBranchAddress("run", &run, &b_run);
-   //fChain->SetBranchAddress("lumi", &lumi, &b_lumi);
+   fChain->SetBranchAddress("lumi", &lumi, &b_lumi);
    //fChain->SetBranchAddress("nvtx", &nvtx, &b_nvtx);
    Notify();
 }
@@ -127,6 +233,8 @@ Bool_t PickEvents2::Notify()
    // to the generated code, but the routine can be extended by the
    // user if needed. The return value is currently not used.
 
+   // the pinned run view points into the index of the previous tree
+   cursor.reset();
    return kTRUE;
 }
 
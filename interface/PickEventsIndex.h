@@ -0,0 +1,165 @@
+//////////////////////////////////////////////////////////
+// Immutable pick list: the sorted per-run view, the lookup backend,
+// the optional Bloom prefilter and the lumi index, built once and
+// then only read. Every member function is const and touches no
+// shared mutable state, so any number of threads may call contains()
+// on the same object without locking.
+//
+// shared() keeps one index per key (list source + build options) for
+// the whole process: the first caller builds it, later callers (other
+// modules, other streams) get the same object. PickEvents2 is the
+// per-stream handle on it, holding the cursor and the counters.
+//////////////////////////////////////////////////////////
+
+#ifndef PickEventsIndex_h
+#define PickEventsIndex_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/CompressedEventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListView.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventBloomFilter.h"
+#include "JetMETStudies/JMEAnalyzer/interface/LumiIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EmbeddedEventList.h"
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class PickEventsIndex {
+public :
+   enum Backend { kSorted, kHash, kCompressed };
+
+   struct Options {
+      Options(Backend b = kSorted, double fpr = 0, UInt_t threads = 0)
+         : backend(b), prefilterFPR(fpr), nThreads(threads) {}
+      Backend backend;
+      double  prefilterFPR; // > 0 builds a Bloom prefilter with that rate
+      UInt_t  nThreads;     // used to sort the runs, <= 1: serial
+      // the part of a cache key that changes the built object
+      std::string key() const;
+   };
+
+   typedef std::shared_ptr<const PickEventsIndex> Ptr;
+
+   // "sorted", "hash" or "compressed"; false for anything else
+   static bool backendFromName(const std::string &name, Backend &backend);
+
+   // Compressed index filled one (run, event, lumi) at a time while the
+   // list is read: no column, per-run array or per-event lumi key is held,
+   // only the compressed blocks and a bounded buffer (see
+   // CompressedEventIndex::Builder) plus one counter per lumi section.
+   // Streams filled in parallel are merged before finish().
+   class Stream {
+   public :
+      explicit Stream(const Options &options) : fOptions(options), fLastLumi(0), fLastCount(0) {}
+
+      void add(Long64_t run, Long64_t event, Long64_t lumi)
+      {
+         fEvents.add(run, event);
+         if (lumi < 0) return;
+         // lists are grouped by lumi: the map is searched when it changes
+         const ULong64_t key = LumiIndex::pack(run, lumi);
+         if (!fLastCount || key != fLastLumi) {
+            fLastLumi = key;
+            fLastCount = &fLumiCounts[key];
+         }
+         ++*fLastCount;
+      }
+      void merge(Stream &other);
+      const Options &options() const { return fOptions; }
+      // the index, with peakBytes set; the stream is left empty
+      std::shared_ptr<PickEventsIndex> finish();
+
+   private :
+      Options                          fOptions;
+      CompressedEventIndex::Builder    fEvents;
+      std::map<ULong64_t, ULong64_t>   fLumiCounts;
+      ULong64_t                        fLastLumi;
+      ULong64_t                       *fLastCount;
+   };
+
+   // runs/events/lumis in any order, duplicates allowed; lumi < 0 means unknown.
+   // The compressed backend goes through a Stream
+   static std::shared_ptr<PickEventsIndex> fromColumns(const std::vector<Long64_t> &runs,
+                                                       const std::vector<Long64_t> &events,
+                                                       const std::vector<Long64_t> &lumis,
+                                                       const Options &options);
+   // binary list file (see EventListFile.h), mapped read-only; null and error set on failure
+   static std::shared_ptr<PickEventsIndex> fromBinary(const std::string &path, bool verify,
+                                                      const Options &options, std::string &error);
+   // a list compiled into the program (EmbeddedEventList.h), looked up in
+   // place: no file, no copy; no prefilter, the lookup is already one probe
+   static std::shared_ptr<PickEventsIndex> fromEmbedded(const EmbeddedEventList &list);
+   // base plus the given pairs, for lists that only grow. Nothing of base
+   // is copied or rebuilt: the result keeps base alive and uses its arrays,
+   // index and prefilter, adding a small index over the new pairs
+   // (OverlayEventIndex), a copy of the Bloom bits with the new pairs set,
+   // and merged arrays for the runs that received events. Appending to an
+   // appended index starts again from the original base, so lookups never
+   // go through more than one overlay; once the additions reach
+   // kMaxAppendedFraction of that base, the list is rebuilt in full.
+   // Null if base keeps no arrays (compressed).
+   static std::shared_ptr<PickEventsIndex> appended(const Ptr &base,
+                                                    const std::vector<Long64_t> &runs,
+                                                    const std::vector<Long64_t> &events,
+                                                    const std::vector<Long64_t> &lumis,
+                                                    const Options &options);
+   static const double kMaxAppendedFraction;
+   // the index cached under key, built by build() if no live one exists.
+   // A failed build (null) is not cached.
+   static Ptr shared(const std::string &key, const std::function<Ptr()> &build);
+
+   bool contains(Long64_t run, Long64_t event) const
+   {
+      if (fFilter && !fFilter->mayContain(run, event)) return false;
+      return fIndex->contains(run, event);
+   }
+
+   // Batch lookup of n (run,event) pairs: bit i of mask (word i/64) is set if
+   // pair i is in the list. Queries are grouped by run and merge-joined
+   // against the sorted per-run arrays; n may be in the millions.
+   void matchBatch(const Long64_t *runs, const Long64_t *events, size_t n, std::vector<ULong64_t> &mask) const;
+   static bool maskBit(const std::vector<ULong64_t> &mask, size_t i) { return (mask[i >> 6] >> (i & 63)) & 1; }
+
+   // whether the list has any event of the run (sorted run numbers, all backends)
+   bool   hasRun(Long64_t run) const { return std::binary_search(fRuns.begin(), fRuns.end(), run); }
+   size_t nRuns() const { return fRuns.size(); }
+
+   const EventIndex       &index() const { return *fIndex; }
+   const EventBloomFilter *filter() const { return fFilter.get(); }
+   // sorted per-run arrays, null for the compressed backend which drops them
+   // and for embedded lists
+   const EventListView    *list() const { return fList.get(); }
+   const LumiIndex        &lumis() const { return fLumis; }
+
+   // appended lists: pairs held on top of the original base, 0 otherwise
+   size_t nAppended() const;
+
+   // filled in by whoever built the index, reported by PickEvents2::printStats
+   double   loadSeconds;
+   Long64_t loadBytes;
+   // heap held at once while building, from the sizes of the containers
+   // (the caller's columns not included); 0 if not known
+   Long64_t peakBytes;
+
+private :
+   PickEventsIndex() : loadSeconds(0), loadBytes(0), peakBytes(0) {}
+   PickEventsIndex(const PickEventsIndex &) = delete;
+   PickEventsIndex &operator=(const PickEventsIndex &) = delete;
+
+   void build(const Options &options);
+
+   std::map<Long64_t, std::vector<Long64_t>> fRunToEvents; // storage behind fList for in-memory lists
+                                                           // (appended: the merged runs that grew only)
+   Ptr                                       fBase;        // appended: the index grown from
+   std::map<Long64_t, std::vector<Long64_t>> fAdded;       // appended: pairs not in fBase, by run
+   std::unique_ptr<EventListView>            fList;
+   std::vector<Long64_t>                     fRuns;
+   std::unique_ptr<EventIndex>               fIndex;
+   std::unique_ptr<EventBloomFilter>         fFilter;
+   LumiIndex                                 fLumis;
+};
+
+#endif
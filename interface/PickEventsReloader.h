@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////
+// Pick list that follows its source files while the job runs.
+//
+// A watcher thread stats the files every few seconds. When they
+// change it builds a new PickEventsIndex next to the one in use and
+// publishes it with an atomic pointer swap: readers never wait for a
+// build, they pick the new index up on their next lookup, and the old
+// one is freed when its last reader lets go of it.
+//
+// Text lists that only grew (same file, bytes before the previous end
+// unchanged) are merged: only the new lines are parsed and laid over
+// the current index, which is not rebuilt (PickEventsIndex::appended). Anything else (a
+// rewritten text list, binary or ROOT lists) is rebuilt in full. A
+// binary list must be replaced by a rename, never rewritten in place,
+// since the current index maps it.
+//////////////////////////////////////////////////////////
+
+#ifndef PickEventsReloader_h
+#define PickEventsReloader_h
+
+#include "JetMETStudies/JMEAnalyzer/interface/PickEventsIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/TextEventList.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PickEventsReloader {
+public :
+   // one binary list, ROOT files holding TTree "tree", or text lists (by extension)
+   PickEventsReloader(const std::vector<std::string> &files, const PickEventsIndex::Options &options);
+   ~PickEventsReloader();
+
+   // builds the first index; false and error set on failure
+   bool load();
+   // checks the files every pollSeconds from a background thread
+   void start(double pollSeconds);
+   void stop();
+   // one check now; true if a new index was published
+   bool poll();
+
+   // the index to use; safe from any thread, never waits for a build
+   PickEventsIndex::Ptr current() const { return std::atomic_load(&fCurrent); }
+   // bumped at every publication: a handle compares it with the value it
+   // saw last to know when to call current() again
+   ULong64_t generation() const { return fGeneration.load(std::memory_order_acquire); }
+   ULong64_t nRebuilds() const { return fRebuilds; }
+   ULong64_t nAppends() const { return fAppends; }
+   std::string error() const;
+
+private :
+   enum Format { kText, kBinary, kRoot };
+   struct Source {
+      std::string path;
+      ULong64_t   inode;
+      Long64_t    size;
+      Long64_t    mtime;    // ns
+      Long64_t    consumed; // text: bytes parsed, up to the last complete line
+      ULong64_t   tailHash; // text: hash of the bytes just before consumed
+   };
+
+   bool stat(Source &source) const;
+   bool readText(Source &source, Long64_t from, TextEventList::Columns &columns);
+   ULong64_t tailHash(const std::string &path, Long64_t end) const;
+   PickEventsIndex::Ptr rebuild(std::vector<Source> &sources);
+   void publish(PickEventsIndex::Ptr index);
+   void setError(const std::string &error);
+
+   Format                   fFormat;
+   PickEventsIndex::Options fOptions;
+   std::vector<Source>      fSources; // as of the published index, watcher thread only
+
+   PickEventsIndex::Ptr   fCurrent; // accessed through std::atomic_load/store only
+   std::atomic<ULong64_t> fGeneration;
+   std::atomic<ULong64_t> fRebuilds;
+   std::atomic<ULong64_t> fAppends;
+
+   mutable std::mutex      fMutex; // guards fError and fStop
+   std::condition_variable fWake;
+   bool                    fStop;
+   std::string             fError;
+   std::thread             fThread;
+};
+
+#endif
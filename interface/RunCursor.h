@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////
+// Run-scoped view on the sorted event numbers of one run.
+//
+// PickEvents2 pins the array of the current run when the run
+// changes and then answers lookups by galloping from the position
+// of the previous lookup, which is amortized near-constant work
+// when the input is ordered by run and lumi.
+//////////////////////////////////////////////////////////
+
+#ifndef RunCursor_h
+#define RunCursor_h
+
+#include <Rtypes.h>
+#include <algorithm>
+#include <cstddef>
+
+class RunCursor {
+public :
+   RunCursor() { reset(); }
+
+   void reset() { pin(-1, 0, 0); }
+
+   void pin(Long64_t run, const Long64_t *events, size_t n)
+   {
+      fRun = run;
+      fEvents = events;
+      fN = n;
+      fPos = 0;
+   }
+
+   bool     pinned(Long64_t run) const { return fRun == run; }
+   Long64_t run() const { return fRun; }
+
+   bool contains(Long64_t event)
+   {
+      if (fN == 0) return false;
+      size_t lo, hi;
+      if (fEvents[fPos] < event) {
+         // gallop forward: fEvents[lo] < event <= fEvents[hi]
+         lo = fPos;
+         size_t step = 1;
+         hi = fPos + step;
+         while (hi < fN && fEvents[hi] < event) {
+            lo = hi;
+            step <<= 1;
+            hi = fPos + step;
+         }
+         if (hi > fN) hi = fN;
+         lo += 1;
+      } else {
+         // gallop backward: fEvents[lo-1] < event <= fEvents[hi]
+         hi = fPos;
+         size_t step = 1;
+         while (step <= fPos && fEvents[fPos - step] >= event) {
+            hi = fPos - step;
+            step <<= 1;
+         }
+         lo = step <= fPos ? fPos - step + 1 : 0;
+      }
+      fPos = std::lower_bound(fEvents + lo, fEvents + hi, event) - fEvents;
+      if (fPos == fN) {
+         fPos = fN - 1;
+         return false;
+      }
+      return fEvents[fPos] == event;
+   }
+
+private :
+   Long64_t        fRun;
+   const Long64_t *fEvents;
+   size_t          fN;
+   size_t          fPos; // lower bound found by the previous lookup
+};
+
+#endif
@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////
+// Text event lists (the PickEvents3 format): any number of files,
+// typically one per run, one event per line as "run:lumi:event",
+// "run lumi event", "run event" or just "event". A bare event number
+// takes its run from the last number in the file name
+// (e.g. run_297050.txt). Lines starting with '#' are ignored.
+//
+// Files are mapped read-only and parsed with std::from_chars; large
+// files are cut at line boundaries so that all chunks of all files
+// are parsed in parallel. The result is the same run/event/lumi
+// columns PickEvents2::Loop reads from the ROOT list.
+//////////////////////////////////////////////////////////
+
+#ifndef TextEventList_h
+#define TextEventList_h
+
+#include <Rtypes.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+class TextEventList {
+public :
+   struct Columns {
+      std::vector<Long64_t> runs;
+      std::vector<Long64_t> events;
+      std::vector<Long64_t> lumis;  // -1 where the line has no lumi
+   };
+
+   // bytes of text handed to one parsing task
+   static const size_t kChunkSize = 64 << 20;
+
+   TextEventList() : fBadLines(0), fBytes(0) {}
+
+   // parse [begin,end); defaultRun is used for bare event numbers (-1: none).
+   // Returns the number of malformed lines, which are skipped.
+   static size_t parse(const char *begin, const char *end, Long64_t defaultRun, Columns &out);
+   // last decimal number in the base name of path, -1 if there is none
+   static Long64_t runFromFileName(const std::string &path);
+
+   // nThreads <= 1 parses serially
+   bool load(const std::vector<std::string> &files, UInt_t nThreads = 0);
+   // parses one file chunk by chunk, handing each chunk's columns to consume
+   // instead of keeping them: memory stays bounded whatever the file size
+   bool stream(const std::string &path, const std::function<void(const Columns &)> &consume);
+
+   const Columns     &columns() const { return fColumns; }
+   Columns           &columns() { return fColumns; }
+   size_t             badLines() const { return fBadLines; }
+   size_t             bytesRead() const { return fBytes; }
+   const std::string &error() const { return fError; }
+
+private :
+   Columns     fColumns;
+   size_t      fBadLines;
+   size_t      fBytes;
+   std::string fError;
+};
+
+#endif
@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////
+// Positions of a fixed set of trigger paths in a trigger menu.
+//
+// Paths are given without their version ("HLT_IsoMu24", a trailing
+// "_v" or "_v*" is dropped) and match the menu name itself or any
+// "<name>_v<digits>". The table of a menu is built the first time the
+// menu is seen, keyed by the caller (the parameterSetID of the
+// TriggerNames): per event the decisions are then direct reads of the
+// indices held. The key is a string to keep this class free of the
+// framework; callers compare the ID itself with the last one seen and
+// only call resolve() when it changes, so no key is built per event.
+//////////////////////////////////////////////////////////
+
+#ifndef TriggerPathTable_h
+#define TriggerPathTable_h
+
+#include <map>
+#include <string>
+#include <vector>
+
+class TriggerPathTable {
+public :
+   explicit TriggerPathTable(const std::vector<std::string> &paths);
+
+   // "HLT_IsoMu24_v", "HLT_IsoMu24_v*" -> "HLT_IsoMu24"
+   static std::string baseName(const std::string &path);
+   // menuName is path or path_v<digits>
+   static bool matches(const std::string &menuName, const std::string &path);
+
+   // index in the menu of each path, -1 if absent; menuNames is only read
+   // when menuId has not been seen before
+   const std::vector<int> &resolve(const std::string &menuId, const std::vector<std::string> &menuNames);
+
+   size_t             size() const { return fPaths.size(); }
+   const std::string &path(size_t i) const { return fPaths[i]; }
+   size_t             nMenus() const { return fTables.size(); }
+
+private :
+   std::vector<std::string>                fPaths; // base names
+   std::map<std::string, std::vector<int>> fTables;
+   const std::string                      *fLastId; // key of fLast in fTables
+   const std::vector<int>                 *fLast;
+};
+
+#endif
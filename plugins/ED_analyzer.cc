@@ -5,9 +5,11 @@
 
 
 // system include files
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <map>
+#include <fstream>
 #include <assert.h>
 
 // user include files
@@ -26,12 +28,15 @@
 #include "FWCore/Framework/interface/Event.h"
 #include "FWCore/Framework/interface/EventSetup.h"
 #include "FWCore/Framework/interface/ESHandle.h"
+#include "FWCore/Framework/interface/ESWatcher.h"
 #include "FWCore/Framework/interface/MakerMacros.h"
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
 #include "FWCore/Utilities/interface/InputTag.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 #include "DataFormats/Common/interface/TriggerResults.h"
+#include "DataFormats/Provenance/interface/ParameterSetID.h"
 #include "DataFormats/PatCandidates/interface/PackedCandidate.h"
 #include "DataFormats/PatCandidates/interface/Electron.h"
 #include "DataFormats/PatCandidates/interface/Jet.h"
@@ -65,6 +70,9 @@
 //#include "JetMETStudies/JMEAnalyzer/python/RochesterCorrections/Rocco//R.h"
 #include "JetMETStudies/JMEAnalyzer/interface/RoccoR.h"
 #include "JetMETStudies/JMEAnalyzer/interface/PickEvents2.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventSelection.h"
+#include "JetMETStudies/JMEAnalyzer/interface/TriggerPathTable.h"
+#include "JetMETStudies/JMEAnalyzer/interface/DecisionBits.h"
 
 const int  N_METFilters=16;
 enum METFilterIndex{
@@ -85,6 +93,34 @@ enum METFilterIndex{
   idx_PassEcalDeadCellBoundaryEnergyFilter_Update,
   idx_PassBadChargedCandidateFilter_Update
 };
+//analyze() stages that can reject the event, cheapest first
+const int  N_Stages=2;
+enum AnalyzeStage{
+  kStageSelection,
+  kStageSkim
+};
+const char* const StageNames[N_Stages]={"pick list and selection","skim"};
+
+//Filters up to idx_PassecalBadCalibFilter_Update are read from TriggerResults, the others rerun on MINIAOD
+const int N_METFilterPaths=idx_PassecalBadCalibFilter_Update;
+const char* const METFilterNames[N_METFilters]={
+  "Flag_goodVertices",
+  "Flag_globalTightHalo2016Filter",
+  "Flag_globalSuperTightHalo2016Filter",
+  "Flag_HBHENoiseFilter",
+  "Flag_HBHENoiseIsoFilter",
+  "Flag_EcalDeadCellTriggerPrimitiveFilter",
+  "Flag_BadPFMuonFilter",
+  "Flag_BadChargedCandidateFilter",
+  "Flag_eeBadScFilter",
+  "Flag_ecalBadCalibFilter",
+  "Flag_ecalLaserCorrFilter",
+  "Flag_EcalDeadCellBoundaryEnergyFilter",
+  "PassecalBadCalibFilter_Update",
+  "PassecalLaserCorrFilter_Update",
+  "PassEcalDeadCellBoundaryEnergyFilter_Update",
+  "PassBadChargedCandidateFilter_Update"
+};
 
 
 //
@@ -115,7 +151,16 @@ class JMEAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
   virtual void analyze(const edm::Event&, const edm::EventSetup&) override;
   virtual void endJob() override;
   virtual bool PassSkim();
-  virtual bool GetMETFilterDecision(const edm::Event& iEvent, edm::Handle<TriggerResults> METFilterResults, TString studiedfilter);
+  //analyze() stages that only fill the tree, see there
+  virtual void FillSkimInputs(const edm::Event& iEvent);
+  virtual void FillEventInfo(const edm::Event& iEvent);
+  virtual void FillJets(const edm::Event& iEvent, const edm::EventSetup& iSetup);
+  virtual void FillPFCandidates(const edm::Event& iEvent);
+  virtual void FillGenInfo(const edm::Event& iEvent);
+  bool CountStage(int stage, bool pass);
+  //JES uncertainty of each jet given by its eta and pt arrays, appended to unc
+  void GetJECUncertainties(const vector<Float_t>& eta, const vector<Float_t>& pt, vector<Float_t>& unc);
+  virtual void FillMETFilterDecisions(const edm::Event& iEvent, edm::Handle<TriggerResults> METFilterResults);
   virtual bool GetIdxFilterDecision(int it);
   virtual TString GetIdxFilterName(int it);
   virtual void InitandClearStuff();
@@ -219,6 +264,11 @@ class JMEAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
   bool PassecalLaserCorrFilter_Update;  
   bool PassEcalDeadCellBoundaryEnergyFilter_Update;
   bool PassBadChargedCandidateFilter_Update;
+  //The flags above by METFilterIndex, and the TriggerResults indices of the first N_METFilterPaths, cached per menu
+  bool* metFilterFlags_[N_METFilters];
+  TriggerPathTable metFilterPaths_;
+  edm::ParameterSetID metFilterMenu_;
+  const std::vector<int>* metFilterIndex_;
 
   //Jets 
   vector<Float_t>  _jetEta;
@@ -241,6 +291,9 @@ class JMEAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
   vector <Float_t>  _jetPhiGen;
   vector <Float_t>  _jetPtGenWithNu;
   vector<Float_t>  _jetJECuncty;
+  //AK4PFchs JES uncertainty, rebuilt when the JetCorrectionsRecord IOV changes
+  edm::ESWatcher<JetCorrectionsRecord> jecWatcher_;
+  std::unique_ptr<JetCorrectionUncertainty> jecUnc_;
   vector<Float_t>  _jetPUMVA; 
   vector<Float_t>  _jetPUMVAUpdate2017;
   vector<Float_t>  _jetPUMVAUpdate2018;
@@ -323,44 +376,25 @@ class JMEAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
   Float_t _genmet;
   Float_t _genmet_phi;
 
-  //Triggers
-  bool HLT_Photon110EB_TightID_TightIso;
-  bool HLT_Photon165_R9Id90_HE10_IsoM;
-  bool HLT_Photon120_R9Id90_HE10_IsoM;
-  bool HLT_Photon90_R9Id90_HE10_IsoM;
-  bool HLT_Photon75_R9Id90_HE10_IsoM;
-  bool HLT_Photon50_R9Id90_HE10_IsoM;
-  bool HLT_Photon200;
-  bool HLT_Photon175;
-  bool HLT_PFMETNoMu120_PFMHTNoMu120_IDTight_PFHT60;
-  bool HLT_PFMETNoMu120_PFMHTNoMu120_IDTight;
-  bool HLT_PFMET120_PFMHT120_IDTight_PFHT60;
-  bool HLT_PFMET120_PFMHT120_IDTight;
-  bool HLT_PFHT1050;
-  bool HLT_PFHT900;
-  bool HLT_PFJet500;
-  bool HLT_AK8PFJet500;
-  bool HLT_Ele35_WPTight_Gsf ;
-  bool HLT_Ele32_WPTight_Gsf ;
-  bool HLT_Ele27_WPTight_Gsf;
-  bool HLT_IsoMu27;
-  bool HLT_IsoMu24;
-  bool HLT_IsoTkMu24;
-  bool HLT_TkMu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ;
-  bool HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ;
-  bool HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL;
-  bool HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ;
-  bool HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8;
-  bool HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL;
-  bool HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ;
-  bool HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ;
-  bool HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ;
-  bool HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL;
-  bool HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL;
+  //Triggers: one flag per configured path (HLTPaths), indices resolved once per trigger menu
+  TriggerPathTable hltPaths_;
+  std::unique_ptr<bool[]> hltPass_;
+  //menu of the last event and its table: the ID compare is all a run of events pays
+  edm::ParameterSetID hltMenu_;
+  const std::vector<int>* hltIndex_;
+  //PackDecisions: the HLT flags then the MET filters, as bits of one branch (see DecisionBits)
+  bool packDecisions_;
+  DecisionBits decisionBits_;
   bool _l1prefire;
 
   RoccoR rc; 
   PickEvents2 pe;
+  PickEvents2 peVeto;
+  //events entering and rejected by each analyze() stage
+  unsigned long long stageEvents_[N_Stages];
+  unsigned long long stageRejected_[N_Stages];
+  EventSelection selection;
+  string pickEventsTelemetryFile_;
   //const unsigned int maxEvents = -1;
 };
 
@@ -368,6 +402,52 @@ class JMEAnalyzer : public edm::one::EDAnalyzer<edm::one::SharedResources>  {
 // constants, enums and typedefs
 //
 
+//Trigger paths stored by default, version suffix dropped
+static vector<string> defaultHLTPaths(){
+  return vector<string>{
+    "HLT_Photon110EB_TightID_TightIso",
+    "HLT_Photon165_R9Id90_HE10_IsoM",
+    "HLT_Photon120_R9Id90_HE10_IsoM",
+    "HLT_Photon90_R9Id90_HE10_IsoM",
+    "HLT_Photon75_R9Id90_HE10_IsoM",
+    "HLT_Photon50_R9Id90_HE10_IsoM",
+    "HLT_Photon200",
+    "HLT_Photon175",
+    "HLT_PFMETNoMu120_PFMHTNoMu120_IDTight_PFHT60",
+    "HLT_PFMETNoMu120_PFMHTNoMu120_IDTight",
+    "HLT_PFMET120_PFMHT120_IDTight_PFHT60",
+    "HLT_PFMET120_PFMHT120_IDTight",
+    "HLT_PFHT1050",
+    "HLT_PFHT900",
+    "HLT_PFJet500",
+    "HLT_AK8PFJet500",
+    "HLT_Ele35_WPTight_Gsf",
+    "HLT_Ele32_WPTight_Gsf",
+    "HLT_Ele27_WPTight_Gsf",
+    "HLT_IsoMu27",
+    "HLT_IsoMu24",
+    "HLT_IsoTkMu24",
+    "HLT_TkMu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ",
+    "HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ",
+    "HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL",
+    "HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ",
+    "HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8",
+    "HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL",
+    "HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ",
+    "HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ",
+    "HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ",
+    "HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL",
+    "HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL",
+  };
+}
+
+static PickEvents2::IndexBackend pickEventsBackend(const string& name){
+  PickEvents2::IndexBackend backend;
+  if(!PickEvents2::backendFromName(name, backend))
+    throw cms::Exception("Configuration") << "Unknown PickEventsBackend '" << name << "', expected 'sorted', 'hash' or 'compressed'";
+  return backend;
+}
+
 
 //
 // static data member definitions
@@ -426,9 +506,26 @@ JMEAnalyzer::JMEAnalyzer(const edm::ParameterSet& iConfig)
   DropBadJets_(iConfig.getParameter<bool>("DropBadJets")),
   ApplyPhotonID_(iConfig.getParameter<bool>("ApplyPhotonID")),
   Skim_(iConfig.getParameter<string>("Skim")),
-  Debug_(iConfig.getParameter<bool>("Debug"))
+  Debug_(iConfig.getParameter<bool>("Debug")),
+  metFilterPaths_(vector<string>(METFilterNames, METFilterNames+N_METFilterPaths)),
+  metFilterIndex_(nullptr),
+  hltPaths_(iConfig.getUntrackedParameter<vector<string> >("HLTPaths",defaultHLTPaths())),
+  hltPass_(new bool[hltPaths_.size()]()),
+  hltIndex_(nullptr),
+  packDecisions_(iConfig.getUntrackedParameter<bool>("PackDecisions",false)),
+  pe(0, pickEventsBackend(iConfig.getUntrackedParameter<string>("PickEventsBackend","sorted")),
+     iConfig.getUntrackedParameter<double>("PickEventsPrefilterFPR",0.))
 {
    //now do what ever initialization is needed
+  std::fill(stageEvents_, stageEvents_+N_Stages, 0ULL);
+  std::fill(stageRejected_, stageRejected_+N_Stages, 0ULL);
+  bool* flags[N_METFilters]={
+    &Flag_goodVertices, &Flag_globalTightHalo2016Filter, &Flag_globalSuperTightHalo2016Filter, &Flag_HBHENoiseFilter,
+    &Flag_HBHENoiseIsoFilter, &Flag_EcalDeadCellTriggerPrimitiveFilter, &Flag_BadPFMuonFilter, &Flag_BadChargedCandidateFilter,
+    &Flag_eeBadScFilter, &Flag_ecalBadCalibFilter, &Flag_ecalLaserCorrFilter, &Flag_EcalDeadCellBoundaryEnergyFilter,
+    &PassecalBadCalibFilter_Update, &PassecalLaserCorrFilter_Update, &PassEcalDeadCellBoundaryEnergyFilter_Update, &PassBadChargedCandidateFilter_Update
+  };
+  std::copy(flags, flags+N_METFilters, metFilterFlags_);
   edm::Service<TFileService> fs; 
   h_nvtx  = fs->make<TH1F>("h_nvtx" , "Number of reco vertices;N_{vtx};Events"  ,    100, 0., 100.);
   h_PFMet  = fs->make<TH1F>("h_PFMet" , "Type 1 PFMET (GeV);Type 1 PFMET (GeV);Events"  ,    1000, 0., 5000.);
@@ -436,6 +533,68 @@ JMEAnalyzer::JMEAnalyzer(const edm::ParameterSet& iConfig)
 
   outputTree = fs->make<TTree>("tree","tree");
 
+  //MINIAOD input is ordered by run and lumi: look events up in a pinned per-run view
+  pe.runScoped = iConfig.getUntrackedParameter<bool>("PickEventsRunScoped",false);
+  pe.nLoadThreads = iConfig.getUntrackedParameter<unsigned int>("PickEventsLoadThreads",0);
+
+  //Binary list made by pickEventsBuildList: mapped read-only instead of reading the ROOT list
+  string binaryList = iConfig.getUntrackedParameter<string>("PickEventsBinaryList","");
+  //Text lists (one file per run, PickEvents3 format), parsed in parallel instead of reading the ROOT list
+  vector<string> textLists = iConfig.getUntrackedParameter<vector<string> >("PickEventsTextLists",vector<string>());
+  //Long jobs can follow a list that keeps growing: its files are checked every PickEventsReloadSeconds
+  //and a new index is swapped in between two events, appended text lines being merged into the current one
+  double reloadSeconds = iConfig.getUntrackedParameter<double>("PickEventsReloadSeconds",0.);
+  //Selection counters are dumped at endJob as a table and as JSON, to this file if set, else to stdout
+  pickEventsTelemetryFile_ = iConfig.getUntrackedParameter<string>("PickEventsTelemetryFile","");
+  //Small frozen list compiled into the library by a pickEventsEmbed header: no file is read at all
+  string embeddedList = iConfig.getUntrackedParameter<string>("PickEventsEmbeddedList","");
+  if(!embeddedList.empty()){
+    if(!pe.LoadEmbedded(embeddedList))
+      throw cms::Exception("Configuration") << "No embedded event list " << embeddedList << " in this library";
+  }
+  else if(reloadSeconds > 0){
+    vector<string> watched = !binaryList.empty() ? vector<string>(1, binaryList) : textLists;
+    if(!pe.Watch(watched, reloadSeconds))
+      throw cms::Exception("Configuration") << "Cannot load the pick list";
+  }
+  else{
+    if(!binaryList.empty() && !pe.LoadBinary(binaryList.c_str()))
+      throw cms::Exception("Configuration") << "Cannot load binary event list " << binaryList;
+    if(!textLists.empty() && !pe.LoadText(textLists))
+      throw cms::Exception("Configuration") << "Cannot load text event lists";
+    //Otherwise build the index of the ROOT list now: analyze() only reads it (shared with other instances on the same list)
+    //or, lazily, only index its runs and read the events of each run the job meets
+    bool lazyLoad = iConfig.getUntrackedParameter<bool>("PickEventsLazyLoad",false);
+    if(binaryList.empty() && textLists.empty()){
+      if(!lazyLoad) pe.Loop();
+      else if(!pe.LoadLazy())
+        throw cms::Exception("Configuration") << "Cannot index the ROOT pick list by run";
+    }
+  }
+
+  //The pick list, certified-lumi JSON masks (their union), event ranges ("run:event-run:event")
+  //and veto lists (text) are combined into one predicate, evaluated once per event
+  selection.addList(&pe, false, "pick list");
+  vector<string> lumiMasks = iConfig.getUntrackedParameter<vector<string> >("PickEventsLumiMasks",vector<string>());
+  if(!lumiMasks.empty()){
+    auto mask = std::make_shared<IntervalMask>();
+    for(const string& path : lumiMasks)
+      if(!mask->loadLumiJson(path)) throw cms::Exception("Configuration") << mask->error();
+    selection.addLumiMask(mask, false, "PickEventsLumiMasks");
+  }
+  vector<string> eventRanges = iConfig.getUntrackedParameter<vector<string> >("PickEventsEventRanges",vector<string>());
+  if(!eventRanges.empty()){
+    auto ranges = std::make_shared<IntervalMask>();
+    if(!ranges->addRanges(eventRanges)) throw cms::Exception("Configuration") << ranges->error();
+    selection.addEventRanges(ranges, false, "PickEventsEventRanges");
+  }
+  vector<string> vetoLists = iConfig.getUntrackedParameter<vector<string> >("PickEventsVetoLists",vector<string>());
+  if(!vetoLists.empty()){
+    if(!peVeto.LoadText(vetoLists)) throw cms::Exception("Configuration") << "Cannot load veto event lists";
+    selection.addList(&peVeto, true, "PickEventsVetoLists");
+  }
+  selection.compile();
+
   
   rc.init(edm::FileInPath(RochCorrFile_).fullPath()); 
   
@@ -466,91 +625,33 @@ JMEAnalyzer::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
   
   _runNb = iEvent.id().run();
   _eventNb = iEvent.id().event();
-  //return;
-  // PickEvents2 pe;
-  //pe.Loop();
-  //  unsigned int iEvent;
-  //  for(iEvent=0; iEvent != maxEvents; ++iEvent) {
-  // _eventNb = iEvent.id().event();
-  //}
-  bool _ismatch = pe.match(_runNb, _eventNb);
-  if (! _ismatch) return;
-  
-  
   _lumiBlock = iEvent.luminosityBlock();
   _bx=iEvent.bunchCrossing();
-  
-  //Vertices
-  edm::Handle<std::vector<Vertex> > theVertices;
-  iEvent.getByToken(verticesToken_,theVertices) ;
-  _n_PV = theVertices->size();
-  
-  //Rho
-  edm::Handle<double> rhoJets;
-  iEvent.getByToken(rhoJetsToken_,rhoJets);
-  _rho = *rhoJets;
-
-  //Rho Neutral Central 
-  edm::Handle<double> rhoJetsNC;
-  iEvent.getByToken(rhoJetsNCToken_,rhoJetsNC);
-  _rhoNC = *rhoJetsNC;
-
 
-  
-  //MET filters are stored in TriggerResults::RECO or TriggerResults::PAT . Should take the latter if it exists
-  edm::Handle<TriggerResults> METFilterResults;
-  iEvent.getByToken(metfilterspatToken_, METFilterResults);
-  if(!(METFilterResults.isValid())) iEvent.getByToken(metfiltersrecoToken_, METFilterResults);
-  
-  Flag_goodVertices= GetMETFilterDecision(iEvent,METFilterResults,"Flag_goodVertices");
-  Flag_globalTightHalo2016Filter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_globalTightHalo2016Filter");
-  Flag_globalSuperTightHalo2016Filter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_globalSuperTightHalo2016Filter");
-  Flag_HBHENoiseFilter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_HBHENoiseFilter");
-  Flag_HBHENoiseIsoFilter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_HBHENoiseIsoFilter");
-  Flag_EcalDeadCellTriggerPrimitiveFilter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_EcalDeadCellTriggerPrimitiveFilter");
-  Flag_BadPFMuonFilter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_BadPFMuonFilter");
-  Flag_BadChargedCandidateFilter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_BadChargedCandidateFilter");
-  Flag_eeBadScFilter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_eeBadScFilter");
-  Flag_ecalBadCalibFilter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_ecalBadCalibFilter");
-  Flag_EcalDeadCellBoundaryEnergyFilter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_EcalDeadCellBoundaryEnergyFilter");
-  Flag_ecalLaserCorrFilter= GetMETFilterDecision(iEvent,METFilterResults,"Flag_ecalLaserCorrFilter");
-  
-
-  //Now accessing the decisions of some filters that we reran on top of MINIAOD
-  edm::Handle<bool> handle_PassecalBadCalibFilter_Update ;
-  iEvent.getByToken(ecalBadCalibFilterUpdateToken_,handle_PassecalBadCalibFilter_Update);
-  if(handle_PassecalBadCalibFilter_Update.isValid()) PassecalBadCalibFilter_Update =  (*handle_PassecalBadCalibFilter_Update );
-  else{ 
-    if(Debug_) std::cout <<"handle_PassecalBadCalibFilter_Update.isValid() =false" <<endl;
-    PassecalBadCalibFilter_Update = true;
-  }
-  
-  edm::Handle<bool> handle_PassecalLaserCorrFilter_Update ;
-  iEvent.getByToken(ecalLaserCorrFilterUpdateToken_,handle_PassecalLaserCorrFilter_Update);
-  if(handle_PassecalLaserCorrFilter_Update.isValid())PassecalLaserCorrFilter_Update =  (*handle_PassecalLaserCorrFilter_Update );
-  else{ 
-    if(Debug_) std::cout <<"handle_PassecalLaserCorrFilter_Update.isValid() =false" <<endl;
-    PassecalLaserCorrFilter_Update = true;
-  }
-
-  edm::Handle<bool> handle_PassEcalDeadCellBoundaryEnergyFilter_Update;
-  iEvent.getByToken(ecalDeadCellBoundaryEnergyFilterUpdateToken_,handle_PassEcalDeadCellBoundaryEnergyFilter_Update);
-  if(handle_PassEcalDeadCellBoundaryEnergyFilter_Update.isValid())PassEcalDeadCellBoundaryEnergyFilter_Update =  (*handle_PassEcalDeadCellBoundaryEnergyFilter_Update );
-  else{  
-    if(Debug_) std::cout <<"handle_PassEcalDeadCellBoundaryEnergyFilter_Update.isValid =false" <<endl; 
-    PassEcalDeadCellBoundaryEnergyFilter_Update = true;
-  }
-
-  edm::Handle<bool> handle_PassBadChargedCandidateFilter_Update;
-  iEvent.getByToken(badChargedCandidateFilterUpdateToken_,handle_PassBadChargedCandidateFilter_Update);
-  if(handle_PassBadChargedCandidateFilter_Update.isValid())PassBadChargedCandidateFilter_Update =  (*handle_PassBadChargedCandidateFilter_Update );
-  else{  
-    if(Debug_) std::cout <<"handle_PassBadChargedCandidateFilter_Update.isValid =false" <<endl; 
-    PassBadChargedCandidateFilter_Update = true;
-  }
+  //Ordered by cost: an event failing the pick list or Skim_ never reads jets, PF candidates or gen info
+  if(!CountStage(kStageSelection, selection.accept(_runNb, _lumiBlock, _eventNb))) return;
+  FillSkimInputs(iEvent);
+  if(!CountStage(kStageSkim, PassSkim())) return;
+  FillEventInfo(iEvent);
+  FillJets(iEvent, iSetup);
+  FillPFCandidates(iEvent);
+  FillGenInfo(iEvent);
 
+  //Filling trees and histos   
+  if(SaveTree_)outputTree->Fill();
+  h_PFMet->Fill(_met);
+  h_PuppiMet->Fill(_puppimet);
+  h_nvtx->Fill(_n_PV);
+}
 
+bool JMEAnalyzer::CountStage(int stage, bool pass){
+  stageEvents_[stage]++;
+  if(!pass) stageRejected_[stage]++;
+  return pass;
+}
 
+//Leptons, photons and MET: all that PassSkim() looks at
+void JMEAnalyzer::FillSkimInputs(const edm::Event& iEvent){
   edm::Handle< std::vector<pat::Electron> > thePatElectrons;
   iEvent.getByToken(electronToken_,thePatElectrons);
   for( std::vector<pat::Electron>::const_iterator electron = (*thePatElectrons).begin(); electron != (*thePatElectrons).end(); electron++ ) {
@@ -624,20 +725,137 @@ JMEAnalyzer::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     _phPtcorr.push_back( ptphotoncorr);
     
   }
+
+  //Type 1 PFMET
+  edm::Handle< vector<pat::MET> > ThePFMET;
+  iEvent.getByToken(metToken_, ThePFMET);
+  const vector<pat::MET> *pfmetcol = ThePFMET.product();
+  const pat::MET *pfmet;
+  pfmet = &(pfmetcol->front());
+  _met = pfmet->pt();
+  _met_phi = pfmet->phi();
+
+
+  //PUPPI MET
+  edm::Handle< vector<pat::MET> > ThePUPPIMET;
+  iEvent.getByToken(puppimetToken_, ThePUPPIMET);
+  const vector<pat::MET> *puppimetcol = ThePUPPIMET.product();
+  const pat::MET *puppimet;
+  puppimet = &(puppimetcol->front());
+  _puppimet = puppimet->pt();
+  _puppimet_phi = puppimet->phi();
+}
+
+//Vertices, rho, MET filters, pile up, triggers and prefiring
+void JMEAnalyzer::FillEventInfo(const edm::Event& iEvent){
+  //Vertices
+  edm::Handle<std::vector<Vertex> > theVertices;
+  iEvent.getByToken(verticesToken_,theVertices) ;
+  _n_PV = theVertices->size();
   
-  if(!PassSkim()) return;
+  //Rho
+  edm::Handle<double> rhoJets;
+  iEvent.getByToken(rhoJetsToken_,rhoJets);
+  _rho = *rhoJets;
 
-    
+  //Rho Neutral Central 
+  edm::Handle<double> rhoJetsNC;
+  iEvent.getByToken(rhoJetsNCToken_,rhoJetsNC);
+  _rhoNC = *rhoJetsNC;
+
+
+  
+  //MET filters are stored in TriggerResults::RECO or TriggerResults::PAT . Should take the latter if it exists
+  edm::Handle<TriggerResults> METFilterResults;
+  iEvent.getByToken(metfilterspatToken_, METFilterResults);
+  if(!(METFilterResults.isValid())) iEvent.getByToken(metfiltersrecoToken_, METFilterResults);
+  
+  FillMETFilterDecisions(iEvent,METFilterResults);
+  
+
+  //Now accessing the decisions of some filters that we reran on top of MINIAOD
+  edm::Handle<bool> handle_PassecalBadCalibFilter_Update ;
+  iEvent.getByToken(ecalBadCalibFilterUpdateToken_,handle_PassecalBadCalibFilter_Update);
+  if(handle_PassecalBadCalibFilter_Update.isValid()) PassecalBadCalibFilter_Update =  (*handle_PassecalBadCalibFilter_Update );
+  else{ 
+    if(Debug_) std::cout <<"handle_PassecalBadCalibFilter_Update.isValid() =false" <<endl;
+    PassecalBadCalibFilter_Update = true;
+  }
+  
+  edm::Handle<bool> handle_PassecalLaserCorrFilter_Update ;
+  iEvent.getByToken(ecalLaserCorrFilterUpdateToken_,handle_PassecalLaserCorrFilter_Update);
+  if(handle_PassecalLaserCorrFilter_Update.isValid())PassecalLaserCorrFilter_Update =  (*handle_PassecalLaserCorrFilter_Update );
+  else{ 
+    if(Debug_) std::cout <<"handle_PassecalLaserCorrFilter_Update.isValid() =false" <<endl;
+    PassecalLaserCorrFilter_Update = true;
+  }
+
+  edm::Handle<bool> handle_PassEcalDeadCellBoundaryEnergyFilter_Update;
+  iEvent.getByToken(ecalDeadCellBoundaryEnergyFilterUpdateToken_,handle_PassEcalDeadCellBoundaryEnergyFilter_Update);
+  if(handle_PassEcalDeadCellBoundaryEnergyFilter_Update.isValid())PassEcalDeadCellBoundaryEnergyFilter_Update =  (*handle_PassEcalDeadCellBoundaryEnergyFilter_Update );
+  else{  
+    if(Debug_) std::cout <<"handle_PassEcalDeadCellBoundaryEnergyFilter_Update.isValid =false" <<endl; 
+    PassEcalDeadCellBoundaryEnergyFilter_Update = true;
+  }
+
+  edm::Handle<bool> handle_PassBadChargedCandidateFilter_Update;
+  iEvent.getByToken(badChargedCandidateFilterUpdateToken_,handle_PassBadChargedCandidateFilter_Update);
+  if(handle_PassBadChargedCandidateFilter_Update.isValid())PassBadChargedCandidateFilter_Update =  (*handle_PassBadChargedCandidateFilter_Update );
+  else{  
+    if(Debug_) std::cout <<"handle_PassBadChargedCandidateFilter_Update.isValid =false" <<endl; 
+    PassBadChargedCandidateFilter_Update = true;
+  }
+
+  Handle<std::vector<PileupSummaryInfo> > puInfo;
+  iEvent.getByToken(puInfoToken_, puInfo);
+  if(puInfo.isValid()){
+  vector<PileupSummaryInfo>::const_iterator pvi;
+  for (pvi = puInfo->begin(); pvi != puInfo->end(); ++pvi) {
+    if (pvi->getBunchCrossing() == 0) trueNVtx = pvi->getTrueNumInteractions();
+  }
+  }
+  else trueNVtx = -1.;
+
+  //Triggers 
+  edm::Handle<TriggerResults> trigResults;
+  iEvent.getByToken(trgresultsToken_, trigResults);
+  if( !trigResults.failedToGet() ) {
+    const edm::TriggerNames & trigName = iEvent.triggerNames(*trigResults);
+    if( !hltIndex_ || trigName.parameterSetID() != hltMenu_ ) {
+      hltMenu_ = trigName.parameterSetID();
+      hltIndex_ = &hltPaths_.resolve(hltMenu_.compactForm(), trigName.triggerNames());
+    }
+    const std::vector<int> & hltIndex = *hltIndex_;
+    for( size_t i_Path = 0; i_Path < hltIndex.size(); ++i_Path )
+      hltPass_[i_Path] = hltIndex[i_Path] >= 0 && trigResults->accept(hltIndex[i_Path]);
+  }
+
+  //Prefiring, see: https://github.com/nsmith-/PrefireAnalysis/#usage
+  edm::Handle<BXVector<GlobalAlgBlk>> l1GtHandle;
+  iEvent.getByToken(l1GtToken_, l1GtHandle);
+  _l1prefire= false;
+  if(!IsMC_)_l1prefire = l1GtHandle->begin(-1)->getFinalOR();
+
+  if(packDecisions_){
+    decisionBits_.clear();
+    for(size_t i_Path = 0; i_Path < hltPaths_.size(); ++i_Path) decisionBits_.set(i_Path, hltPass_[i_Path]);
+    for(int it = 0; it < N_METFilters; ++it) decisionBits_.set(hltPaths_.size()+it, *metFilterFlags_[it]);
+  }
+}
+
+void JMEAnalyzer::FillJets(const edm::Event& iEvent, const edm::EventSetup& iSetup){
   //Jets
   
   edm::Handle< std::vector< pat::Jet> > theJets;
   iEvent.getByToken(jetToken_,theJets );
 
   //JES uncties: https://twiki.cern.ch/twiki/bin/view/CMSPublic/WorkBookJetEnergyCorrections#JetCorUncertainties
-  edm::ESHandle<JetCorrectorParametersCollection> JetCorParColl;
-  iSetup.get<JetCorrectionsRecord>().get("AK4PFchs",JetCorParColl); 
-  JetCorrectorParameters const & JetCorPar = (*JetCorParColl)["Uncertainty"];
-  JetCorrectionUncertainty *jecUnc = new JetCorrectionUncertainty(JetCorPar);
+  if(jecWatcher_.check(iSetup) || !jecUnc_){
+    edm::ESHandle<JetCorrectorParametersCollection> JetCorParColl;
+    iSetup.get<JetCorrectionsRecord>().get("AK4PFchs",JetCorParColl); 
+    JetCorrectorParameters const & JetCorPar = (*JetCorParColl)["Uncertainty"];
+    jecUnc_.reset(new JetCorrectionUncertainty(JetCorPar));
+  }
   
   //Value map for the recalculated PU ID
   edm::Handle<edm::ValueMap<float> > pileupJetIdDiscriminantUpdate;
@@ -760,10 +978,6 @@ JMEAnalyzer::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
       _jetRawPt.push_back( (&*jet)->correctedP4("Uncorrected").Pt() );
       _jetPtNoL2L3Res.push_back( (&*jet)->correctedP4("L3Absolute") .Pt() ); 
       _jet_corrjecs.push_back((&*jet)->pt() / (&*jet)->correctedP4("Uncorrected").Pt() );
-      //Accessing uncertainties
-      jecUnc->setJetEta((&*jet)->eta());
-      jecUnc->setJetPt((&*jet)->pt());
-      _jetJECuncty.push_back( jecUnc->getUncertainty(true) );
       
       Float_t jetptgen(-99.), jetetagen(-99.),jetphigen(-99.);
       Float_t jetptgenwithnu(-99.);
@@ -779,29 +993,23 @@ JMEAnalyzer::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
       _jetPtGenWithNu.push_back(jetptgenwithnu);
       
     }
+    //Uncertainties of all the jets kept, in one pass over their eta and pt
+    GetJECUncertainties(_jetEta, _jetPt, _jetJECuncty);
   }
   else if(Debug_){cout << "Invalid jet collection"<<endl;}
-  
-  //Type 1 PFMET
-  edm::Handle< vector<pat::MET> > ThePFMET;
-  iEvent.getByToken(metToken_, ThePFMET);
-  const vector<pat::MET> *pfmetcol = ThePFMET.product();
-  const pat::MET *pfmet;
-  pfmet = &(pfmetcol->front());
-  _met = pfmet->pt();
-  _met_phi = pfmet->phi();
-
-
-  //PUPPI MET
-  edm::Handle< vector<pat::MET> > ThePUPPIMET;
-  iEvent.getByToken(puppimetToken_, ThePUPPIMET);
-  const vector<pat::MET> *puppimetcol = ThePUPPIMET.product();
-  const pat::MET *puppimet;
-  puppimet = &(puppimetcol->front());
-  _puppimet = puppimet->pt();
-  _puppimet_phi = puppimet->phi();
+}
 
+void JMEAnalyzer::GetJECUncertainties(const vector<Float_t>& eta, const vector<Float_t>& pt, vector<Float_t>& unc){
+  size_t n = std::min(eta.size(), pt.size());
+  unc.reserve(unc.size()+n);
+  for(size_t i = 0; i < n; ++i){
+    jecUnc_->setJetEta(eta[i]);
+    jecUnc_->setJetPt(pt[i]);
+    unc.push_back(jecUnc_->getUncertainty(true));
+  }
+}
 
+void JMEAnalyzer::FillPFCandidates(const edm::Event& iEvent){
   //PF candidates
   edm::Handle<pat::PackedCandidateCollection> pfcands;
   iEvent.getByToken(pfcandsToken_ ,pfcands);
@@ -826,7 +1034,10 @@ JMEAnalyzer::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
     _PFcand_pdgId.push_back(p->pdgId());
     _PFcand_fromPV.push_back(p->fromPV(0));//See https://twiki.cern.ch/twiki/bin/view/CMSPublic/WorkBookMiniAOD2017#Packed_ParticleFlow_Candidates
   }
-  
+}
+
+//Gen particles, generator weight and LHE HT
+void JMEAnalyzer::FillGenInfo(const edm::Event& iEvent){
   //Gen particle info
   edm::Handle<GenParticleCollection> TheGenParticles;
   iEvent.getByToken(genpartToken_, TheGenParticles);
@@ -918,81 +1129,8 @@ JMEAnalyzer::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
 
   _genHT = lheht;
   //Tested with QCD/photon jets/DY with madgraphm
-
-
-  Handle<std::vector<PileupSummaryInfo> > puInfo;
-  iEvent.getByToken(puInfoToken_, puInfo);
-  if(puInfo.isValid()){
-  vector<PileupSummaryInfo>::const_iterator pvi;
-  for (pvi = puInfo->begin(); pvi != puInfo->end(); ++pvi) {
-    if (pvi->getBunchCrossing() == 0) trueNVtx = pvi->getTrueNumInteractions();
-  }
-  }
-  else trueNVtx = -1.;
-
-
-  //Triggers 
-  edm::Handle<TriggerResults> trigResults;
-  iEvent.getByToken(trgresultsToken_, trigResults);
-  if( !trigResults.failedToGet() ) {
-    int N_Triggers = trigResults->size();
-    const edm::TriggerNames & trigName = iEvent.triggerNames(*trigResults);
-    for( int i_Trig = 0; i_Trig < N_Triggers; ++i_Trig ) {
-      if (trigResults.product()->accept(i_Trig)) {
-	TString TrigPath =trigName.triggerName(i_Trig);
-	if(TrigPath.Contains("HLT_Photon110EB_TightID_TightIso_v"))HLT_Photon110EB_TightID_TightIso =true;
-	if(TrigPath.Contains("HLT_Photon165_R9Id90_HE10_IsoM_v"))HLT_Photon165_R9Id90_HE10_IsoM =true;
-	if(TrigPath.Contains("HLT_Photon120_R9Id90_HE10_IsoM_v"))HLT_Photon120_R9Id90_HE10_IsoM =true;
-	if(TrigPath.Contains("HLT_Photon90_R9Id90_HE10_IsoM_v"))HLT_Photon90_R9Id90_HE10_IsoM =true;
-	if(TrigPath.Contains("HLT_Photon75_R9Id90_HE10_IsoM_v"))HLT_Photon75_R9Id90_HE10_IsoM =true;
-	if(TrigPath.Contains("HLT_Photon50_R9Id90_HE10_IsoM_v"))HLT_Photon50_R9Id90_HE10_IsoM =true;
-	if(TrigPath.Contains("HLT_Photon200_v"))HLT_Photon200 =true;
-	if(TrigPath.Contains("HLT_Photon175_v"))HLT_Photon175 =true;
-	if(TrigPath.Contains("HLT_PFMETNoMu120_PFMHTNoMu120_IDTight_PFHT60_v"))HLT_PFMETNoMu120_PFMHTNoMu120_IDTight_PFHT60 =true;
-	if(TrigPath.Contains("HLT_PFMETNoMu120_PFMHTNoMu120_IDTight_v"))HLT_PFMETNoMu120_PFMHTNoMu120_IDTight =true;
-	if(TrigPath.Contains("HLT_PFMET120_PFMHT120_IDTight_PFHT60_v"))HLT_PFMET120_PFMHT120_IDTight_PFHT60 =true;
-	if(TrigPath.Contains("HLT_PFMET120_PFMHT120_IDTight_v"))HLT_PFMET120_PFMHT120_IDTight =true;
-	if(TrigPath.Contains("HLT_PFHT1050_v"))HLT_PFHT1050 =true;
-	if(TrigPath.Contains("HLT_PFHT900_v"))HLT_PFHT900 =true;
-	if(TrigPath.Contains("HLT_PFJet500_v"))HLT_PFJet500 =true;
-	if(TrigPath.Contains("HLT_AK8PFJet500_v"))HLT_AK8PFJet500 =true;
-	if(TrigPath.Contains("HLT_Ele35_WPTight_Gsf_v"))HLT_Ele35_WPTight_Gsf =true;
-	if(TrigPath.Contains("HLT_Ele32_WPTight_Gsf_v"))HLT_Ele32_WPTight_Gsf =true;
-	if(TrigPath.Contains("HLT_Ele27_WPTight_Gsf_v"))HLT_Ele27_WPTight_Gsf =true;
-	if(TrigPath.Contains("HLT_IsoMu27_v"))HLT_IsoMu27 =true;
-	if(TrigPath.Contains("HLT_IsoMu24_v"))HLT_IsoMu24 =true;
-	if(TrigPath.Contains("HLT_IsoTkMu24_v"))HLT_IsoTkMu24 =true;
-	if(TrigPath.Contains("HLT_TkMu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ_v"))HLT_TkMu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ =true;
-	if(TrigPath.Contains("HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ_v"))HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ =true;
-	if(TrigPath.Contains("HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_v"))HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL =true;
-	if(TrigPath.Contains("HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_v"))HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ =true;
-	if(TrigPath.Contains("HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8_v"))HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8 =true;
-	if(TrigPath.Contains("HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_v"))HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL =true;
-	if(TrigPath.Contains("HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ_v"))HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ =true;
-	if(TrigPath.Contains("HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ_v"))HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ =true;
-	if(TrigPath.Contains("HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ_v"))HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ =true;
-	if(TrigPath.Contains("HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_v"))HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL =true;
-	if(TrigPath.Contains("HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_v"))HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL =true;
-      }
-    }
-  }
-
-  //Prefiring, see: https://github.com/nsmith-/PrefireAnalysis/#usage
-  edm::Handle<BXVector<GlobalAlgBlk>> l1GtHandle;
-  iEvent.getByToken(l1GtToken_, l1GtHandle);
-  _l1prefire= false;
-  if(!IsMC_)_l1prefire = l1GtHandle->begin(-1)->getFinalOR();
-
-  //Filling trees and histos   
-  if(PassSkim()){
-      if(SaveTree_)outputTree->Fill();
-      h_PFMet->Fill(_met);
-      h_PuppiMet->Fill(_puppimet);
-      h_nvtx->Fill(_n_PV);
-    }
 }
 
-
 // ------------ method called once each job just before starting event loop  ------------
 void
 JMEAnalyzer::beginJob()
@@ -1008,23 +1146,26 @@ JMEAnalyzer::beginJob()
   outputTree->Branch("_rhoNC", &_rhoNC, "_rhoNC/f");
   
 
-  outputTree->Branch("Flag_goodVertices",&Flag_goodVertices,"Flag_goodVertices/O");
-  outputTree->Branch("Flag_globalTightHalo2016Filter",&Flag_globalTightHalo2016Filter,"Flag_globalTightHalo2016Filter/O");
-  outputTree->Branch("Flag_globalSuperTightHalo2016Filter",&Flag_globalSuperTightHalo2016Filter,"Flag_globalSuperTightHalo2016Filter/O");
-  outputTree->Branch("Flag_HBHENoiseFilter",&Flag_HBHENoiseFilter,"Flag_HBHENoiseFilter/O");
-  outputTree->Branch("Flag_HBHENoiseIsoFilter",&Flag_HBHENoiseIsoFilter,"Flag_HBHENoiseIsoFilter/O");
-  outputTree->Branch("Flag_EcalDeadCellTriggerPrimitiveFilter",&Flag_EcalDeadCellTriggerPrimitiveFilter,"Flag_EcalDeadCellTriggerPrimitiveFilter/O");
-  outputTree->Branch("Flag_BadPFMuonFilter",&Flag_BadPFMuonFilter,"Flag_BadPFMuonFilter/O");
-  outputTree->Branch("Flag_BadChargedCandidateFilter",&Flag_BadChargedCandidateFilter,"Flag_BadChargedCandidateFilter/O");
-  outputTree->Branch("Flag_eeBadScFilter",&Flag_eeBadScFilter,"Flag_eeBadScFilter/O");
-  outputTree->Branch("Flag_ecalBadCalibFilter",&Flag_ecalBadCalibFilter,"Flag_ecalBadCalibFilter/O");
-  outputTree->Branch("Flag_ecalLaserCorrFilter",&Flag_ecalLaserCorrFilter,"Flag_ecalLaserCorrFilter/O");
-  outputTree->Branch("Flag_EcalDeadCellBoundaryEnergyFilter",&Flag_EcalDeadCellBoundaryEnergyFilter,"Flag_EcalDeadCellBoundaryEnergyFilter/O");
-
-  outputTree->Branch("PassecalBadCalibFilter_Update",&PassecalBadCalibFilter_Update,"PassecalBadCalibFilter_Update/O");
-  outputTree->Branch("PassecalLaserCorrFilter_Update",&PassecalLaserCorrFilter_Update,"PassecalLaserCorrFilter_Update/O");
-  outputTree->Branch("PassEcalDeadCellBoundaryEnergyFilter_Update",&PassEcalDeadCellBoundaryEnergyFilter_Update,"PassEcalDeadCellBoundaryEnergyFilter_Update/O");
-  outputTree->Branch("PassBadChargedCandidateFilter_Update",&PassBadChargedCandidateFilter_Update,"PassBadChargedCandidateFilter_Update/O");
+  //MET filter flags, unless packed with the triggers below
+  if(!packDecisions_){
+    outputTree->Branch("Flag_goodVertices",&Flag_goodVertices,"Flag_goodVertices/O");
+    outputTree->Branch("Flag_globalTightHalo2016Filter",&Flag_globalTightHalo2016Filter,"Flag_globalTightHalo2016Filter/O");
+    outputTree->Branch("Flag_globalSuperTightHalo2016Filter",&Flag_globalSuperTightHalo2016Filter,"Flag_globalSuperTightHalo2016Filter/O");
+    outputTree->Branch("Flag_HBHENoiseFilter",&Flag_HBHENoiseFilter,"Flag_HBHENoiseFilter/O");
+    outputTree->Branch("Flag_HBHENoiseIsoFilter",&Flag_HBHENoiseIsoFilter,"Flag_HBHENoiseIsoFilter/O");
+    outputTree->Branch("Flag_EcalDeadCellTriggerPrimitiveFilter",&Flag_EcalDeadCellTriggerPrimitiveFilter,"Flag_EcalDeadCellTriggerPrimitiveFilter/O");
+    outputTree->Branch("Flag_BadPFMuonFilter",&Flag_BadPFMuonFilter,"Flag_BadPFMuonFilter/O");
+    outputTree->Branch("Flag_BadChargedCandidateFilter",&Flag_BadChargedCandidateFilter,"Flag_BadChargedCandidateFilter/O");
+    outputTree->Branch("Flag_eeBadScFilter",&Flag_eeBadScFilter,"Flag_eeBadScFilter/O");
+    outputTree->Branch("Flag_ecalBadCalibFilter",&Flag_ecalBadCalibFilter,"Flag_ecalBadCalibFilter/O");
+    outputTree->Branch("Flag_ecalLaserCorrFilter",&Flag_ecalLaserCorrFilter,"Flag_ecalLaserCorrFilter/O");
+    outputTree->Branch("Flag_EcalDeadCellBoundaryEnergyFilter",&Flag_EcalDeadCellBoundaryEnergyFilter,"Flag_EcalDeadCellBoundaryEnergyFilter/O");
+
+    outputTree->Branch("PassecalBadCalibFilter_Update",&PassecalBadCalibFilter_Update,"PassecalBadCalibFilter_Update/O");
+    outputTree->Branch("PassecalLaserCorrFilter_Update",&PassecalLaserCorrFilter_Update,"PassecalLaserCorrFilter_Update/O");
+    outputTree->Branch("PassEcalDeadCellBoundaryEnergyFilter_Update",&PassEcalDeadCellBoundaryEnergyFilter_Update,"PassEcalDeadCellBoundaryEnergyFilter_Update/O");
+    outputTree->Branch("PassBadChargedCandidateFilter_Update",&PassBadChargedCandidateFilter_Update,"PassBadChargedCandidateFilter_Update/O");
+  }
 
 
   outputTree->Branch("_jetEta",&_jetEta);
@@ -1129,39 +1270,17 @@ JMEAnalyzer::beginJob()
   outputTree->Branch("_puppimet_phi", &_puppimet_phi, "_puppimet_phi/f");
   
 
-  outputTree->Branch("HLT_Photon110EB_TightID_TightIso",&HLT_Photon110EB_TightID_TightIso,"HLT_Photon110EB_TightID_TightIso/O");
-  outputTree->Branch("HLT_Photon165_R9Id90_HE10_IsoM",&HLT_Photon165_R9Id90_HE10_IsoM,"HLT_Photon165_R9Id90_HE10_IsoM/O");
-  outputTree->Branch("HLT_Photon120_R9Id90_HE10_IsoM",&HLT_Photon120_R9Id90_HE10_IsoM,"HLT_Photon120_R9Id90_HE10_IsoM/O");
-  outputTree->Branch("HLT_Photon90_R9Id90_HE10_IsoM",&HLT_Photon90_R9Id90_HE10_IsoM,"HLT_Photon90_R9Id90_HE10_IsoM/O");
-  outputTree->Branch("HLT_Photon75_R9Id90_HE10_IsoM",&HLT_Photon75_R9Id90_HE10_IsoM,"HLT_Photon75_R9Id90_HE10_IsoM/O");
-  outputTree->Branch("HLT_Photon50_R9Id90_HE10_IsoM",&HLT_Photon50_R9Id90_HE10_IsoM,"HLT_Photon50_R9Id90_HE10_IsoM/O");
-  outputTree->Branch("HLT_Photon200",&HLT_Photon200,"HLT_Photon200/O");
-  outputTree->Branch("HLT_Photon175",&HLT_Photon175,"HLT_Photon175/O");
-  outputTree->Branch("HLT_PFMETNoMu120_PFMHTNoMu120_IDTight_PFHT60",&HLT_PFMETNoMu120_PFMHTNoMu120_IDTight_PFHT60,"HLT_PFMETNoMu120_PFMHTNoMu120_IDTight_PFHT60/O");
-  outputTree->Branch("HLT_PFMETNoMu120_PFMHTNoMu120_IDTight",&HLT_PFMETNoMu120_PFMHTNoMu120_IDTight,"HLT_PFMETNoMu120_PFMHTNoMu120_IDTight/O");
-  outputTree->Branch("HLT_PFMET120_PFMHT120_IDTight_PFHT60",&HLT_PFMET120_PFMHT120_IDTight_PFHT60,"HLT_PFMET120_PFMHT120_IDTight_PFHT60/O");
-  outputTree->Branch("HLT_PFMET120_PFMHT120_IDTight",&HLT_PFMET120_PFMHT120_IDTight,"HLT_PFMET120_PFMHT120_IDTight/O");
-  outputTree->Branch("HLT_PFHT1050",&HLT_PFHT1050,"HLT_PFHT1050/O");
-  outputTree->Branch("HLT_PFHT900",&HLT_PFHT900,"HLT_PFHT900/O");
-  outputTree->Branch("HLT_PFJet500",&HLT_PFJet500,"HLT_PFJet500/O");
-  outputTree->Branch("HLT_AK8PFJet500",&HLT_AK8PFJet500,"HLT_AK8PFJet500/O");
-  outputTree->Branch("HLT_Ele35_WPTight_Gsf",&HLT_Ele35_WPTight_Gsf,"HLT_Ele35_WPTight_Gsf/O");
-  outputTree->Branch("HLT_Ele32_WPTight_Gsf",&HLT_Ele32_WPTight_Gsf,"HLT_Ele32_WPTight_Gsf/O");
-  outputTree->Branch("HLT_Ele27_WPTight_Gsf",&HLT_Ele27_WPTight_Gsf,"HLT_Ele27_WPTight_Gsf/O");
-  outputTree->Branch("HLT_IsoMu27",&HLT_IsoMu27,"HLT_IsoMu27/O");
-  outputTree->Branch("HLT_IsoMu24",&HLT_IsoMu24,"HLT_IsoMu24/O");
-  outputTree->Branch("HLT_IsoTkMu24",&HLT_IsoTkMu24,"HLT_IsoTkMu24/O");
-  outputTree->Branch("HLT_TkMu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ",&HLT_TkMu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ,"HLT_TkMu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ/O");
-  outputTree->Branch("HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ",&HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ,"HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ/O");
-  outputTree->Branch("HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL",&HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL,"HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL/O");
-  outputTree->Branch("HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ",&HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ,"HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ/O");
-  outputTree->Branch("HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8",&HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8,"HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8/O");
-  outputTree->Branch("HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL",&HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL,"HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL/O");
-  outputTree->Branch("HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ",&HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ,"HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ/O");
-  outputTree->Branch("HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ",&HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ,"HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ/O");
-  outputTree->Branch("HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ",&HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ,"HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ/O");
-  outputTree->Branch("HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL",&HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL,"HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL/O");
-  outputTree->Branch("HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL",&HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL,"HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL/O");
+  if(!packDecisions_){
+    for(size_t i_Path = 0; i_Path < hltPaths_.size(); ++i_Path)
+      outputTree->Branch(hltPaths_.path(i_Path).c_str(), &hltPass_[i_Path], (hltPaths_.path(i_Path)+"/O").c_str());
+  }
+  else{
+    vector<string> names;
+    for(size_t i_Path = 0; i_Path < hltPaths_.size(); ++i_Path) names.push_back(hltPaths_.path(i_Path));
+    names.insert(names.end(), METFilterNames, METFilterNames+N_METFilters);
+    decisionBits_ = DecisionBits(names);
+    decisionBits_.attach(outputTree);
+  }
   if(!IsMC_)outputTree->Branch("_l1prefire",&_l1prefire,"_l1prefire/O");
   
 }
@@ -1170,6 +1289,20 @@ JMEAnalyzer::beginJob()
 void
 JMEAnalyzer::endJob()
 {
+  std::cout << "JMEAnalyzer stages (events in, rejected):" << std::endl;
+  for(int stage = 0; stage < N_Stages; ++stage)
+    std::cout << "  " << StageNames[stage] << ": " << stageEvents_[stage] << ", " << stageRejected_[stage] << std::endl;
+  pe.printStats(std::cout);
+  if(selection.size() > 1) selection.printStats(std::cout);
+  if(pickEventsTelemetryFile_.empty()){
+    std::cout << "PickEvents2 telemetry: ";
+    pe.writeStatsJson(std::cout);
+  }
+  else{
+    std::ofstream telemetry(pickEventsTelemetryFile_.c_str());
+    pe.writeStatsJson(telemetry);
+    if(!telemetry) std::cerr << "JMEAnalyzer: cannot write " << pickEventsTelemetryFile_ << std::endl;
+  }
 }
 
 // ------------ method fills 'descriptions' with the allowed parameters for the module  ------------
@@ -1188,59 +1321,31 @@ JMEAnalyzer::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
   //descriptions.addDefault(desc);
 }
 
-bool JMEAnalyzer::GetMETFilterDecision(const edm::Event& iEvent,edm::Handle<TriggerResults> METFilterResults, TString studiedfilter){
-  
-  if( !METFilterResults.failedToGet() ) {
-    int N_MetFilters = METFilterResults->size();
-    const edm::TriggerNames & metfilterName = iEvent.triggerNames(*METFilterResults);
-    for( int i_Metfilter = 0; i_Metfilter < N_MetFilters; ++i_Metfilter ) {
-      TString MetfilterPath =metfilterName.triggerName(i_Metfilter);
-      if(MetfilterPath.Index(studiedfilter) >=0)  return METFilterResults.product()->accept(i_Metfilter);
-      
-    }
+void JMEAnalyzer::FillMETFilterDecisions(const edm::Event& iEvent,edm::Handle<TriggerResults> METFilterResults){
+  //A filter missing from the results (or no results at all) counts as passed
+  if( METFilterResults.failedToGet() ) {
+    for(int it = 0; it < N_METFilterPaths; ++it) *metFilterFlags_[it] = true;
+    return;
+  }
+  const edm::TriggerNames & metfilterName = iEvent.triggerNames(*METFilterResults);
+  if( !metFilterIndex_ || metfilterName.parameterSetID() != metFilterMenu_ ) {
+    metFilterMenu_ = metfilterName.parameterSetID();
+    metFilterIndex_ = &metFilterPaths_.resolve(metFilterMenu_.compactForm(), metfilterName.triggerNames());
   }
-   return true; 
+  const std::vector<int> & filterIndex = *metFilterIndex_;
+  for(int it = 0; it < N_METFilterPaths; ++it)
+    *metFilterFlags_[it] = filterIndex[it] < 0 || METFilterResults->accept(filterIndex[it]);
 }
 
 
 bool JMEAnalyzer::GetIdxFilterDecision(int it){
-  if(it== idx_Flag_goodVertices)return  Flag_goodVertices;
-  else if(it==  idx_Flag_globalTightHalo2016Filter)return   Flag_globalTightHalo2016Filter;
-  else if(it==  idx_Flag_globalSuperTightHalo2016Filter)return   Flag_globalSuperTightHalo2016Filter;
-  else if(it==  idx_Flag_HBHENoiseFilter)return   Flag_HBHENoiseFilter;
-  else if(it==  idx_Flag_HBHENoiseIsoFilter)return   Flag_HBHENoiseIsoFilter;
-  else if(it==  idx_Flag_EcalDeadCellTriggerPrimitiveFilter)return   Flag_EcalDeadCellTriggerPrimitiveFilter;
-  else if(it==  idx_Flag_BadPFMuonFilter)return   Flag_BadPFMuonFilter;
-  else if(it==  idx_Flag_BadChargedCandidateFilter)return   Flag_BadChargedCandidateFilter;
-  else if(it==  idx_Flag_eeBadScFilter)return   Flag_eeBadScFilter;
-  else if(it==  idx_Flag_ecalBadCalibFilter)return   Flag_ecalBadCalibFilter;
-  else if(it==  idx_Flag_ecalLaserCorrFilter)return   Flag_ecalLaserCorrFilter;
-  else if(it==  idx_Flag_EcalDeadCellBoundaryEnergyFilter)return   Flag_EcalDeadCellBoundaryEnergyFilter;
-  else if(it==  idx_PassecalBadCalibFilter_Update)return   PassecalBadCalibFilter_Update;
-  else if(it==  idx_PassecalLaserCorrFilter_Update)return   PassecalLaserCorrFilter_Update;
-  else if(it==  idx_PassEcalDeadCellBoundaryEnergyFilter_Update)return   PassEcalDeadCellBoundaryEnergyFilter_Update;
-  else if(it==  idx_PassBadChargedCandidateFilter_Update)return   PassBadChargedCandidateFilter_Update;
-  else return false;
+  if(it < 0 || it >= N_METFilters) return false;
+  return *metFilterFlags_[it];
 }
 
 TString JMEAnalyzer::GetIdxFilterName(int it){
-  if(it==idx_Flag_goodVertices)return "Flag_goodVertices";
-  else if(it== idx_Flag_globalTightHalo2016Filter)return "Flag_globalTightHalo2016Filter";
-  else if(it== idx_Flag_globalSuperTightHalo2016Filter)return "Flag_globalSuperTightHalo2016Filter";
-  else if(it== idx_Flag_HBHENoiseFilter)return "Flag_HBHENoiseFilter";
-  else if(it== idx_Flag_HBHENoiseIsoFilter)return "Flag_HBHENoiseIsoFilter";
-  else if(it== idx_Flag_EcalDeadCellTriggerPrimitiveFilter)return "Flag_EcalDeadCellTriggerPrimitiveFilter";
-  else if(it== idx_Flag_BadPFMuonFilter)return "Flag_BadPFMuonFilter";
-  else if(it== idx_Flag_BadChargedCandidateFilter)return "Flag_BadChargedCandidateFilter";
-  else if(it== idx_Flag_eeBadScFilter)return "Flag_eeBadScFilter";
-  else if(it== idx_Flag_ecalBadCalibFilter)return "Flag_ecalBadCalibFilter";
-  else if(it== idx_Flag_ecalLaserCorrFilter)return "Flag_ecalLaserCorrFilter";
-  else if(it== idx_Flag_EcalDeadCellBoundaryEnergyFilter)return "Flag_EcalDeadCellBoundaryEnergyFilter";
-  else if(it== idx_PassecalBadCalibFilter_Update)return "PassecalBadCalibFilter_Update";
-  else if(it== idx_PassecalLaserCorrFilter_Update)return "PassecalLaserCorrFilter_Update";
-  else if(it== idx_PassEcalDeadCellBoundaryEnergyFilter_Update )return "PassEcalDeadCellBoundaryEnergyFilter_Update";
-  else if(it== idx_PassBadChargedCandidateFilter_Update )return "PassBadChargedCandidateFilter_Update";
-  else return "";
+  if(it < 0 || it >= N_METFilters) return "";
+  return METFilterNames[it];
 }
 
 
@@ -1354,39 +1459,7 @@ void JMEAnalyzer::InitandClearStuff(){
 
 
 
-  HLT_Photon110EB_TightID_TightIso=false;
-  HLT_Photon165_R9Id90_HE10_IsoM=false;
-  HLT_Photon120_R9Id90_HE10_IsoM=false;
-  HLT_Photon90_R9Id90_HE10_IsoM=false;
-  HLT_Photon75_R9Id90_HE10_IsoM=false;
-  HLT_Photon50_R9Id90_HE10_IsoM=false;
-  HLT_Photon200=false;
-  HLT_Photon175=false;
-  HLT_PFMETNoMu120_PFMHTNoMu120_IDTight_PFHT60=false;
-  HLT_PFMETNoMu120_PFMHTNoMu120_IDTight=false;
-  HLT_PFMET120_PFMHT120_IDTight_PFHT60=false;
-  HLT_PFMET120_PFMHT120_IDTight=false;
-  HLT_PFHT1050=false;
-  HLT_PFHT900=false;
-  HLT_PFJet500=false;
-  HLT_AK8PFJet500=false;
-  HLT_Ele35_WPTight_Gsf =false;
-  HLT_Ele32_WPTight_Gsf =false;
-  HLT_Ele27_WPTight_Gsf=false;
-  HLT_IsoMu27=false;
-  HLT_IsoMu24=false;
-  HLT_IsoTkMu24=false;
-  HLT_TkMu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ=false;
-  HLT_Mu17_TrkIsoVVL_TkMu8_TrkIsoVVL_DZ=false;
-  HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL=false;
-  HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ=false;
-  HLT_Mu17_TrkIsoVVL_Mu8_TrkIsoVVL_DZ_Mass3p8=false;
-  HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL=false;
-  HLT_Ele23_Ele12_CaloIdL_TrackIdL_IsoVL_DZ=false;
-  HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL_DZ=false;
-  HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL_DZ=false;
-  HLT_Mu23_TrkIsoVVL_Ele12_CaloIdL_TrackIdL_IsoVL=false;
-  HLT_Mu8_TrkIsoVVL_Ele23_CaloIdL_TrackIdL_IsoVL=false;  
+  std::fill(hltPass_.get(), hltPass_.get()+hltPaths_.size(), false);
 }
 
 bool JMEAnalyzer::PassSkim(){
@@ -1425,8 +1498,7 @@ bool JMEAnalyzer::PassSkim(){
     if( ngoodphotons>0) return true;
     return false;
   }
-  else if(Skim_=="MET100"&&_met<100) return false;
-  else if(Skim_=="MET100"&&_met>100) return true;
+  else if(Skim_=="MET100") return _met>100;
    
 
 
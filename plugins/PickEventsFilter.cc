@@ -0,0 +1,221 @@
+// -*- C++ -*-
+//
+// Package:    JetMETStudies/JMEAnalyzer
+// Class:      PickEventsFilter
+//
+/**\class PickEventsFilter PickEventsFilter.cc JetMETStudies/JMEAnalyzer/plugins/PickEventsFilter.cc
+
+ Description: keeps only the events of a pick list
+
+ Implementation:
+     Put it first on the path: events that are not in the list stop there,
+     before any producer runs or any product is read. Only the event ID is
+     used. The list is loaded once into a PickEventsIndex shared with every
+     other module using the same list (JMEAnalyzer included), and lookups
+     are const, so the filter is a global module running on all streams.
+     With PickEventsReloadSeconds > 0 the list files are watched and each
+     stream picks up a reloaded index at its next event. With
+     PickEventsLazyLoad the ROOT list is only indexed by run, and the
+     events of a run are read when a stream first meets it.
+*/
+
+
+// system include files
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// user include files
+#include "FWCore/Framework/interface/Frameworkfwd.h"
+#include "FWCore/Framework/interface/global/EDFilter.h"
+
+#include "FWCore/Framework/interface/Event.h"
+#include "FWCore/Framework/interface/MakerMacros.h"
+
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/ParameterSet/interface/ConfigurationDescriptions.h"
+#include "FWCore/ParameterSet/interface/ParameterSetDescription.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include "JetMETStudies/JMEAnalyzer/interface/PickEvents2.h"
+
+using namespace std;
+
+namespace pickevents {
+  //index in use by one stream, and the reloader generation it came from;
+  //with a lazy list, the events of the run the stream is in
+  struct StreamIndex {
+    std::shared_ptr<const PickEventsIndex> index;
+    unsigned long long generation;
+    Long64_t run;
+    const std::vector<Long64_t>* events;
+  };
+}
+
+//
+// class declaration
+//
+
+class PickEventsFilter : public edm::global::EDFilter<edm::StreamCache<pickevents::StreamIndex>> {
+   public:
+      explicit PickEventsFilter(const edm::ParameterSet&);
+      ~PickEventsFilter() override;
+
+      static void fillDescriptions(edm::ConfigurationDescriptions& descriptions);
+
+   private:
+      std::unique_ptr<pickevents::StreamIndex> beginStream(edm::StreamID) const override;
+      bool filter(edm::StreamID, edm::Event&, const edm::EventSetup&) const override;
+      void endJob() override;
+
+      // ----------member data ---------------------------
+      std::shared_ptr<const PickEventsIndex> index_;
+      std::shared_ptr<PickEventsReloader> reloader_;
+      std::shared_ptr<LazyEventList> lazy_;
+      mutable std::atomic<unsigned long long> nPass_;
+      mutable std::atomic<unsigned long long> nFail_;
+      mutable std::atomic<unsigned long long> nanoseconds_;
+};
+
+//
+// constructors and destructor
+//
+PickEventsFilter::PickEventsFilter(const edm::ParameterSet& iConfig):
+  nPass_(0),
+  nFail_(0),
+  nanoseconds_(0)
+{
+  PickEvents2::IndexBackend backend;
+  string backendName = iConfig.getUntrackedParameter<string>("PickEventsBackend");
+  if(!PickEvents2::backendFromName(backendName, backend))
+    throw cms::Exception("Configuration") << "Unknown PickEventsBackend '" << backendName << "', expected 'sorted', 'hash' or 'compressed'";
+
+  string binaryList = iConfig.getUntrackedParameter<string>("PickEventsBinaryList");
+  vector<string> textLists = iConfig.getUntrackedParameter<vector<string> >("PickEventsTextLists");
+  string rootList = iConfig.getUntrackedParameter<string>("PickEventsRootList");
+  string embeddedList = iConfig.getUntrackedParameter<string>("PickEventsEmbeddedList");
+
+  //The ROOT list is only opened when no embedded, binary or text list is given
+  TTree* tree = 0;
+  if(embeddedList.empty() && binaryList.empty() && textLists.empty() && !rootList.empty()){
+    TFile* f = TFile::Open(rootList.c_str());
+    if(f && !f->IsZombie()) f->GetObject("tree",tree);
+    if(!tree) throw cms::Exception("Configuration") << "No TTree 'tree' in pick list " << rootList;
+  }
+  //PickEvents2 opens its default list when given no tree
+  PickEvents2 pe(tree, backend,
+                 iConfig.getUntrackedParameter<double>("PickEventsPrefilterFPR"));
+  pe.nLoadThreads = iConfig.getUntrackedParameter<unsigned int>("PickEventsLoadThreads");
+  bool ok = true;
+  double reloadSeconds = iConfig.getUntrackedParameter<double>("PickEventsReloadSeconds");
+  if(!embeddedList.empty()) ok = pe.LoadEmbedded(embeddedList);
+  else if(reloadSeconds > 0) ok = pe.Watch(!binaryList.empty() ? vector<string>(1, binaryList) : textLists, reloadSeconds);
+  else if(!binaryList.empty()) ok = pe.LoadBinary(binaryList.c_str());
+  else if(!textLists.empty()) ok = pe.LoadText(textLists);
+  else if(iConfig.getUntrackedParameter<bool>("PickEventsLazyLoad")) ok = pe.LoadLazy();
+  else pe.Loop();
+  if(!ok || (!pe.index && !pe.lazy)) throw cms::Exception("Configuration") << "Cannot load the pick list";
+  //a watched list is only held through the reloader, so replaced indexes can be freed
+  if(pe.reloader) reloader_ = pe.reloader;
+  else if(pe.lazy) lazy_ = pe.lazy;
+  else index_ = pe.index;
+}
+
+
+PickEventsFilter::~PickEventsFilter()
+{
+}
+
+
+//
+// member functions
+//
+
+// ------------ method called once per stream before its first event  ------------
+std::unique_ptr<pickevents::StreamIndex>
+PickEventsFilter::beginStream(edm::StreamID) const
+{
+  auto stream = std::make_unique<pickevents::StreamIndex>(pickevents::StreamIndex{index_, 0, -1, 0});
+  //generation first: an index newer than it only costs one more swap
+  if(reloader_){
+    stream->generation = reloader_->generation();
+    stream->index = reloader_->current();
+  }
+  return stream;
+}
+
+// ------------ method called on each new Event  ------------
+bool
+PickEventsFilter::filter(edm::StreamID iID, edm::Event& iEvent, const edm::EventSetup& iSetup) const
+{
+  auto start = std::chrono::steady_clock::now();
+  pickevents::StreamIndex* stream = streamCache(iID);
+  //a reloaded list is swapped in between two events: a lookup never waits for a build
+  if(reloader_ && reloader_->generation() != stream->generation){
+    stream->generation = reloader_->generation();
+    stream->index = reloader_->current();
+  }
+  bool pass;
+  if(lazy_){
+    //events come run by run: the run's events are looked up once per run change
+    Long64_t run = iEvent.id().run();
+    if(run != stream->run){
+      stream->run = run;
+      stream->events = lazy_->events(run);
+    }
+    pass = stream->events && std::binary_search(stream->events->begin(), stream->events->end(), Long64_t(iEvent.id().event()));
+  }
+  else pass = stream->index->contains(iEvent.id().run(), iEvent.id().event());
+  nanoseconds_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  if(pass) nPass_++;
+  else nFail_++;
+  return pass;
+}
+
+// ------------ method called once each job just after ending the event loop  ------------
+void
+PickEventsFilter::endJob()
+{
+  unsigned long long n = nPass_ + nFail_;
+  std::shared_ptr<const PickEventsIndex> index = index_;
+  if(reloader_){
+    reloader_->stop();
+    index = reloader_->current();
+  }
+  edm::LogPrint("PickEventsFilter") << "passed " << nPass_ << " / " << n << " events, rejected " << nFail_
+                                   << ", " << nanoseconds_ * 1e-9 << " s in lookups ("
+                                   << (n ? double(nanoseconds_) / n : 0.) << " ns/event), index backend "
+                                   << (index ? index->index().name() : "lazy");
+  if(lazy_)
+    edm::LogPrint("PickEventsFilter") << "pick list read for " << lazy_->nRunsLoaded() << " of " << lazy_->nRuns()
+                                     << " runs, " << lazy_->entriesRead() << " of " << lazy_->entries() << " entries";
+  if(reloader_)
+    edm::LogPrint("PickEventsFilter") << "pick list rebuilt " << reloader_->nRebuilds() << " times, appended to "
+                                     << reloader_->nAppends() << " times";
+}
+
+// ------------ method fills 'descriptions' with the allowed parameters for the module  ------------
+void
+PickEventsFilter::fillDescriptions(edm::ConfigurationDescriptions& descriptions) {
+  edm::ParameterSetDescription desc;
+  desc.addUntracked<string>("PickEventsBackend","sorted");
+  desc.addUntracked<double>("PickEventsPrefilterFPR",0.);
+  desc.addUntracked<unsigned int>("PickEventsLoadThreads",0);
+  desc.addUntracked<string>("PickEventsBinaryList","");
+  desc.addUntracked<vector<string> >("PickEventsTextLists",vector<string>());
+  desc.addUntracked<string>("PickEventsRootList","");
+  desc.addUntracked<double>("PickEventsReloadSeconds",0.);
+  desc.addUntracked<string>("PickEventsEmbeddedList","");
+  desc.addUntracked<bool>("PickEventsLazyLoad",false);
+  descriptions.add("pickEventsFilter",desc);
+}
+
+//define this as a plug-in
+DEFINE_FWK_MODULE(PickEventsFilter);
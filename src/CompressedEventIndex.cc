@@ -0,0 +1,178 @@
+#include "JetMETStudies/JMEAnalyzer/interface/CompressedEventIndex.h"
+#include <algorithm>
+
+namespace {
+   void putVarint(std::vector<unsigned char> &bytes, ULong64_t value)
+   {
+      while (value >= 0x80) {
+         bytes.push_back((unsigned char)(value | 0x80));
+         value >>= 7;
+      }
+      bytes.push_back((unsigned char)value);
+   }
+
+   ULong64_t getVarint(const unsigned char *&p)
+   {
+      ULong64_t value = 0;
+      int shift = 0;
+      unsigned char byte;
+      do {
+         byte = *p++;
+         value |= ULong64_t(byte & 0x7f) << shift;
+         shift += 7;
+      } while (byte & 0x80);
+      return value;
+   }
+}
+
+CompressedEventIndex::CompressedEventIndex(const EventListView &list) : fN(0)
+{
+   fRuns.reserve(list.nRuns());
+   fRunBlock.reserve(list.nRuns() + 1);
+   for (size_t ir = 0; ir < list.nRuns(); ++ir) addRun(list.run(ir), list.events(ir), list.nEvents(ir));
+   finish();
+}
+
+void CompressedEventIndex::addRun(Long64_t run, const Long64_t *events, size_t n)
+{
+   fRuns.push_back(run);
+   fRunBlock.push_back(fBlockFirst.size());
+   for (size_t j = 0; j < n; ++j) {
+      if (j % kBlockSize == 0) {
+         fBlockFirst.push_back(events[j]);
+         fBlockBytes.push_back(fBytes.size());
+         continue;
+      }
+      putVarint(fBytes, ULong64_t(events[j] - events[j - 1]));
+   }
+   fN += n;
+}
+
+void CompressedEventIndex::finish()
+{
+   fRunBlock.push_back(fBlockFirst.size());
+   fBlockBytes.push_back(fBytes.size());
+
+   fRuns.shrink_to_fit();
+   fRunBlock.shrink_to_fit();
+   fBlockFirst.shrink_to_fit();
+   fBlockBytes.shrink_to_fit();
+   fBytes.shrink_to_fit();
+}
+
+void CompressedEventIndex::Builder::notePeak(size_t extra)
+{
+   const size_t bytes = fPending * sizeof(Long64_t) + fSegmentBytes + extra;
+   if (bytes > fPeakBytes) fPeakBytes = bytes;
+}
+
+void CompressedEventIndex::Builder::flush(Run &r)
+{
+   if (r.pending.empty()) return;
+   notePeak(0);
+   const size_t n = r.pending.size();
+   std::sort(r.pending.begin(), r.pending.end());
+   r.pending.erase(std::unique(r.pending.begin(), r.pending.end()), r.pending.end());
+   // the first event as is, then the deltas
+   std::vector<unsigned char> segment;
+   Long64_t previous = 0;
+   for (Long64_t event : r.pending) {
+      putVarint(segment, ULong64_t(event - previous));
+      previous = event;
+   }
+   segment.shrink_to_fit();
+   fSegmentBytes += segment.size();
+   r.segments.push_back(std::move(segment));
+   fPending -= std::min(fPending, n);
+   std::vector<Long64_t>().swap(r.pending);
+}
+
+void CompressedEventIndex::Builder::flushAll()
+{
+   for (auto &it : fRunsBeingBuilt) flush(it.second);
+}
+
+void CompressedEventIndex::Builder::merge(Builder &other)
+{
+   notePeak(other.fPending * sizeof(Long64_t) + other.fSegmentBytes);
+   for (auto &it : other.fRunsBeingBuilt) {
+      Run &r = fRunsBeingBuilt[it.first];
+      Run &o = it.second;
+      r.pending.insert(r.pending.end(), o.pending.begin(), o.pending.end());
+      for (auto &segment : o.segments) r.segments.push_back(std::move(segment));
+   }
+   fPending += other.fPending;
+   fSegmentBytes += other.fSegmentBytes;
+   fN += other.fN;
+   if (other.fPeakBytes > fPeakBytes) fPeakBytes = other.fPeakBytes;
+   other.fRunsBeingBuilt.clear();
+   other.fPending = other.fSegmentBytes = other.fN = 0;
+}
+
+std::unique_ptr<CompressedEventIndex>
+CompressedEventIndex::Builder::finish(const std::function<void(Long64_t, const Long64_t *, size_t)> &perRun)
+{
+   std::unique_ptr<CompressedEventIndex> index(new CompressedEventIndex());
+   std::vector<Long64_t> events;
+   for (auto it = fRunsBeingBuilt.begin(); it != fRunsBeingBuilt.end(); it = fRunsBeingBuilt.erase(it)) {
+      Run &r = it->second;
+      const bool sorted = r.pending.empty() && r.segments.size() == 1;
+      const size_t npending = r.pending.size();
+      events.swap(r.pending);
+      for (const auto &segment : r.segments) {
+         const unsigned char *p = segment.data(), *end = p + segment.size();
+         Long64_t event = 0;
+         while (p != end) {
+            event += Long64_t(getVarint(p));
+            events.push_back(event);
+         }
+      }
+      if (!sorted) {
+         std::sort(events.begin(), events.end());
+         events.erase(std::unique(events.begin(), events.end()), events.end());
+      }
+      notePeak(events.capacity() * sizeof(Long64_t) + index->bytes());
+      fPending -= std::min(fPending, npending);
+      for (const auto &segment : r.segments) fSegmentBytes -= segment.size();
+      if (perRun) perRun(it->first, events.data(), events.size());
+      index->addRun(it->first, events.data(), events.size());
+      events.clear();
+   }
+   index->finish();
+   fPending = fSegmentBytes = fN = 0;
+   return index;
+}
+
+bool CompressedEventIndex::contains(Long64_t run, Long64_t event) const
+{
+   auto rit = std::lower_bound(fRuns.begin(), fRuns.end(), run);
+   if (rit == fRuns.end() || *rit != run) return false;
+   const size_t ir = rit - fRuns.begin();
+
+   // last block of the run starting at or before the event
+   auto first = fBlockFirst.begin() + fRunBlock[ir];
+   auto last = fBlockFirst.begin() + fRunBlock[ir + 1];
+   auto bit = std::upper_bound(first, last, event);
+   if (bit == first) return false;
+   const size_t ib = (bit - fBlockFirst.begin()) - 1;
+
+   Long64_t value = fBlockFirst[ib];
+   const unsigned char *p = fBytes.data() + fBlockBytes[ib];
+   const unsigned char *end = fBytes.data() + fBlockBytes[ib + 1];
+   while (value < event && p != end) value += Long64_t(getVarint(p));
+   return value == event;
+}
+
+size_t CompressedEventIndex::bytes() const
+{
+   return fRuns.capacity() * sizeof(Long64_t) + fRunBlock.capacity() * sizeof(size_t) +
+          fBlockFirst.capacity() * sizeof(Long64_t) + fBlockBytes.capacity() * sizeof(size_t) +
+          fBytes.capacity();
+}
+
+void CompressedEventIndex::printStats(std::ostream &os) const
+{
+   EventIndex::printStats(os);
+   os << "  runs: " << fRuns.size() << "\n"
+      << "  blocks: " << fBlockFirst.size() << "\n";
+}
@@ -0,0 +1,44 @@
+#include "JetMETStudies/JMEAnalyzer/interface/DecisionBits.h"
+#include <TList.h>
+#include <TNamed.h>
+#include <TTree.h>
+
+const char *const DecisionBits::kBranchName = "decisionBits";
+const char *const DecisionBits::kMetadataName = "decisionBitNames";
+
+DecisionBits::DecisionBits(const std::vector<std::string> &names)
+   : fNames(names), fWords((names.size() + 63) / 64, 0ULL)
+{
+}
+
+void DecisionBits::attach(TTree *tree)
+{
+   std::string joined;
+   for (size_t i = 0; i < fNames.size(); ++i) joined += (i ? "," : "") + fNames[i];
+   tree->GetUserInfo()->Add(new TNamed(kMetadataName, joined.c_str()));
+   const std::string leaf = std::string(kBranchName) + "[" + std::to_string(fWords.size()) + "]/l";
+   tree->Branch(kBranchName, fWords.data(), leaf.c_str());
+}
+
+bool DecisionBits::read(TTree *tree)
+{
+   TNamed *meta = dynamic_cast<TNamed *>(tree->GetUserInfo()->FindObject(kMetadataName));
+   if (!meta || !tree->GetBranch(kBranchName)) return false;
+   fNames.clear();
+   const std::string joined = meta->GetTitle();
+   for (size_t begin = 0; begin < joined.size();) {
+      size_t end = joined.find(',', begin);
+      if (end == std::string::npos) end = joined.size();
+      fNames.push_back(joined.substr(begin, end - begin));
+      begin = end + 1;
+   }
+   fWords.assign((fNames.size() + 63) / 64, 0ULL);
+   return tree->SetBranchAddress(kBranchName, fWords.data()) >= 0;
+}
+
+int DecisionBits::bit(const std::string &name) const
+{
+   for (size_t i = 0; i < fNames.size(); ++i)
+      if (fNames[i] == name) return int(i);
+   return -1;
+}
@@ -0,0 +1,10 @@
+#include "JetMETStudies/JMEAnalyzer/interface/EmbeddedEventIndex.h"
+
+void EmbeddedEventIndex::printStats(std::ostream &os) const
+{
+   EventIndex::printStats(os);
+   os << "  slots: " << fList.nSlots() << "\n"
+      << "  buckets: " << fList.nBuckets() << "\n"
+      << "  table bytes (read-only data): "
+      << fList.nSlots() * sizeof(EmbeddedEvent) + fList.nBuckets() * sizeof(UInt_t) << "\n";
+}
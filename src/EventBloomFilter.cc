@@ -0,0 +1,61 @@
+#include "JetMETStudies/JMEAnalyzer/interface/EventBloomFilter.h"
+#include <algorithm>
+#include <cmath>
+
+EventBloomFilter::EventBloomFilter(const EventListView &list, double fpr)
+   : EventBloomFilter(list.totalEvents(), fpr)
+{
+   add(list);
+}
+
+EventBloomFilter::EventBloomFilter(size_t n, double fpr)
+   : fFPR(fpr), fK(1), fN(n)
+{
+   // classic Bloom sizing, with ~25% more bits to make up for the
+   // uneven block occupancy (PickEvents2 reports the observed rate)
+   const double ln2 = std::log(2.);
+   const double bitsPerKey = -1.25 * std::log(fpr) / (ln2 * ln2);
+   fK = std::max(1, std::min(16, int(std::lround(-std::log2(fpr)))));
+   size_t nblocks = size_t(std::ceil(bitsPerKey * fN / 512.));
+   if (nblocks == 0) nblocks = 1;
+   fBlocks.assign(nblocks, Block());
+   fN = 0;
+}
+
+void EventBloomFilter::add(const EventListView &list)
+{
+   for (size_t ir = 0; ir < list.nRuns(); ++ir) add(list.run(ir), list.events(ir), list.nEvents(ir));
+}
+
+void EventBloomFilter::add(Long64_t run, const Long64_t *events, size_t n)
+{
+   fN += n;
+   for (size_t j = 0; j < n; ++j) {
+      const ULong64_t h = keyHash(run, events[j]);
+      Block &b = fBlocks[((h >> 32) * fBlocks.size()) >> 32];
+      const ULong64_t g = eventHash(h);
+      const UInt_t h1 = UInt_t(g), h2 = UInt_t(g >> 32) | 1;
+      for (int i = 0; i < fK; ++i) {
+         const UInt_t bit = (h1 + i * h2) & 511;
+         b.w[bit >> 6] |= 1ULL << (bit & 63);
+      }
+   }
+}
+
+ULong64_t EventBloomFilter::keyHash(Long64_t run, Long64_t event)
+{
+   return eventHash(eventHash((ULong64_t)run) ^ (ULong64_t)event);
+}
+
+bool EventBloomFilter::mayContain(Long64_t run, Long64_t event) const
+{
+   const ULong64_t h = keyHash(run, event);
+   const Block &b = fBlocks[((h >> 32) * fBlocks.size()) >> 32];
+   const ULong64_t g = eventHash(h);
+   const UInt_t h1 = UInt_t(g), h2 = UInt_t(g >> 32) | 1;
+   for (int i = 0; i < fK; ++i) {
+      const UInt_t bit = (h1 + i * h2) & 511;
+      if (!(b.w[bit >> 6] & (1ULL << (bit & 63)))) return false;
+   }
+   return true;
+}
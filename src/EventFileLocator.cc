@@ -0,0 +1,169 @@
+#include "JetMETStudies/JMEAnalyzer/interface/EventFileLocator.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+bool EventFileLocator::read(const std::string &path)
+{
+   std::ifstream in(path.c_str());
+   if (!in) {
+      fError = "cannot open " + path;
+      return false;
+   }
+   std::string line;
+   size_t nline = 0;
+   File *file = 0;
+   Lumi *open = 0; // an L line waiting for its E line
+   auto malformed = [&]() {
+      fError = path + ":" + std::to_string(nline) + ": malformed locator line";
+      return false;
+   };
+   while (std::getline(in, line)) {
+      ++nline;
+      if (line.empty()) continue;
+      std::istringstream fields(line);
+      char tag;
+      fields >> tag;
+      if (open) {
+         // the gaps between consecutive events, starting from the first one
+         if (tag != 'E') return malformed();
+         open->events.reserve(open->nEvents);
+         open->events.push_back(open->firstEvent);
+         for (Long64_t gap; fields >> gap;) {
+            if (gap <= 0) return malformed();
+            open->events.push_back(open->events.back() + gap);
+         }
+         if (!fields.eof() || open->events.size() != open->nEvents || open->events.back() != open->lastEvent)
+            return malformed();
+         open = 0;
+         continue;
+      }
+      if (line.size() >= 2 && line[0] == 'F' && line[1] == ' ') {
+         fFiles.push_back(File{line.substr(2), std::vector<Lumi>()});
+         file = &fFiles.back();
+         continue;
+      }
+      Lumi l;
+      if (!file || tag != 'L' || !(fields >> l.run >> l.lumi >> l.firstEvent >> l.lastEvent >> l.nEvents) ||
+          l.nEvents == 0)
+         return malformed();
+      file->lumis.push_back(l);
+      open = &file->lumis.back();
+   }
+   if (open) return malformed();
+   fError.clear();
+   return true;
+}
+
+bool EventFileLocator::write(const std::string &path) const
+{
+   std::ofstream out(path.c_str());
+   for (const File &f : fFiles) {
+      out << "F " << f.name << "\n";
+      for (const Lumi &l : f.lumis) {
+         out << "L " << l.run << " " << l.lumi << " " << l.firstEvent << " " << l.lastEvent << " " << l.nEvents << "\n";
+         out << "E";
+         for (size_t i = 1; i < l.events.size(); ++i) out << " " << l.events[i] - l.events[i - 1];
+         out << "\n";
+      }
+   }
+   out.close();
+   return bool(out);
+}
+
+void EventFileLocator::add(const File &file)
+{
+   for (File &f : fFiles) {
+      if (f.name == file.name) {
+         f = file;
+         return;
+      }
+   }
+   fFiles.push_back(file);
+}
+
+std::vector<EventFileLocator::Selection> EventFileLocator::select(const PickEventsIndex &index) const
+{
+   std::vector<Selection> result;
+   const EventListView *list = index.list();
+   if (!list) return result;
+
+   // picked events held by every file
+   std::vector<Selection> candidates;
+   for (const File &f : fFiles) {
+      Selection s;
+      s.file = f.name;
+      for (const Lumi &l : f.lumis) {
+         // no pruning on the list's lumis: events picked without one (lumi < 0)
+         // would be lost, and the exact intersection below is as cheap
+         const size_t ir = list->findRun(l.run);
+         if (ir == list->nRuns()) continue;
+         const Long64_t *events = list->events(ir), *end = events + list->nEvents(ir);
+         const Long64_t *first = std::lower_bound(events, end, l.firstEvent);
+         const Long64_t *last = std::upper_bound(first, end, l.lastEvent);
+         // both sorted: walk the shorter one, binary search the other
+         const Long64_t *held = l.events.data(), *heldEnd = held + l.events.size();
+         if (size_t(last - first) <= l.events.size()) {
+            for (const Long64_t *e = first; e != last; ++e)
+               if (std::binary_search(held, heldEnd, *e)) s.events.push_back(Event{l.run, *e});
+         } else {
+            for (const Long64_t *e = held; e != heldEnd; ++e)
+               if (std::binary_search(first, last, *e)) s.events.push_back(Event{l.run, *e});
+         }
+      }
+      if (s.events.empty()) continue;
+      std::sort(s.events.begin(), s.events.end());
+      s.events.erase(std::unique(s.events.begin(), s.events.end()), s.events.end());
+      candidates.push_back(std::move(s));
+   }
+
+   // greedy set cover: take the file with the most events not yet covered
+   while (!candidates.empty()) {
+      size_t best = 0, bestCount = 0;
+      for (size_t i = 0; i < candidates.size(); ++i) {
+         if (candidates[i].events.size() > bestCount) {
+            best = i;
+            bestCount = candidates[i].events.size();
+         }
+      }
+      if (bestCount == 0) break;
+      Selection chosen = std::move(candidates[best]);
+      candidates.erase(candidates.begin() + best);
+      for (Selection &c : candidates) {
+         std::vector<Event> rest;
+         std::set_difference(c.events.begin(), c.events.end(), chosen.events.begin(), chosen.events.end(),
+                             std::back_inserter(rest));
+         c.events.swap(rest);
+      }
+      result.push_back(std::move(chosen));
+   }
+   return result;
+}
+
+void EventFileLocator::writeSelection(std::ostream &os, const std::vector<Selection> &selection, bool json)
+{
+   if (json) {
+      os << "{";
+      for (size_t i = 0; i < selection.size(); ++i) {
+         os << (i ? ",\n \"" : "\"") << selection[i].file << "\": [";
+         for (size_t j = 0; j < selection[i].events.size(); ++j)
+            os << (j ? ", " : "") << "\"" << selection[i].events[j].run << ":" << selection[i].events[j].event << "\"";
+         os << "]";
+      }
+      os << "}\n";
+      return;
+   }
+   os << "import FWCore.ParameterSet.Config as cms\n\n"
+      << "fileNames = cms.untracked.vstring(\n";
+   for (const Selection &s : selection) os << "   \"" << s.file << "\",\n";
+   os << ")\n\n"
+      << "eventsToProcess = cms.untracked.VEventRange()\n"
+      << "eventsToProcess.extend([\n";
+   for (const Selection &s : selection) {
+      os << "   # " << s.file << "\n";
+      for (const Event &e : s.events)
+         os << "   \"" << e.run << ":" << e.event << "-" << e.run << ":" << e.event << "\",\n";
+   }
+   os << "])\n";
+}
@@ -0,0 +1,9 @@
+#include "JetMETStudies/JMEAnalyzer/interface/EventIndex.h"
+
+void EventIndex::printStats(std::ostream &os) const
+{
+   os << "  backend: " << name() << "\n"
+      << "  events: " << size() << "\n"
+      << "  bytes: " << bytes() << "\n"
+      << "  bytes per event: " << (size() ? double(bytes()) / size() : 0.) << "\n";
+}
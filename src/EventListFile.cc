@@ -0,0 +1,174 @@
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ULong64_t eventListChecksum(const void *data, size_t nbytes, ULong64_t h)
+{
+   const unsigned char *p = (const unsigned char *)data;
+   for (size_t i = 0; i < nbytes; i += 8) {
+      ULong64_t w = 0;
+      std::memcpy(&w, p + i, nbytes - i < 8 ? nbytes - i : 8);
+      h ^= w * 0x9e3779b97f4a7c15ULL;
+      h = ((h << 27) | (h >> 37)) * 0x87c37b91114253d5ULL + 0x52dce729ULL;
+   }
+   return h;
+}
+
+ULong64_t eventListFileChecksum(const std::string &path)
+{
+   FILE *f = std::fopen(path.c_str(), "rb");
+   if (!f) return 0;
+   std::vector<char> buf(1 << 20);
+   ULong64_t h = 0;
+   size_t n;
+   while ((n = std::fread(buf.data(), 1, buf.size(), f)) > 0) h = eventListChecksum(buf.data(), n, h);
+   std::fclose(f);
+   return h;
+}
+
+EventListWriter::EventListWriter(const std::string &path)
+   : fFile(std::fopen(path.c_str(), "wb")), fChecksum(0), fOk(true)
+{
+   std::memset(&fHeader, 0, sizeof(fHeader));
+   std::memcpy(fHeader.magic, kEventListMagic, sizeof(fHeader.magic));
+   fHeader.version = kEventListVersion;
+   fHeader.headerSize = sizeof(EventListFileHeader);
+   fHeader.eventsOffset = sizeof(EventListFileHeader);
+   // placeholder, rewritten by close()
+   if (fFile) fOk = std::fwrite(&fHeader, sizeof(fHeader), 1, fFile) == 1;
+}
+
+EventListWriter::~EventListWriter()
+{
+   if (fFile) std::fclose(fFile);
+}
+
+void EventListWriter::addRun(Long64_t run, const Long64_t *events, size_t n)
+{
+   if (!fFile || n == 0) return;
+   if (!fRuns.empty() && fRuns.back().run == run) fRuns.back().count += n;
+   else fRuns.push_back(EventListRunEntry{run, fHeader.nEvents, n});
+   fHeader.nEvents += n;
+   fChecksum = eventListChecksum(events, n * sizeof(Long64_t), fChecksum);
+   fOk = fOk && std::fwrite(events, sizeof(Long64_t), n, fFile) == n;
+}
+
+void EventListWriter::addList(const EventListView &list)
+{
+   for (size_t i = 0; i < list.nRuns(); ++i) addRun(list.run(i), list.events(i), list.nEvents(i));
+}
+
+bool EventListWriter::close(ULong64_t sourceChecksum)
+{
+   if (!fFile) return false;
+   fHeader.nRuns = fRuns.size();
+   fHeader.nLumis = fLumis.size();
+   fHeader.runTableOffset = fHeader.eventsOffset + fHeader.nEvents * sizeof(Long64_t);
+   fHeader.lumiTableOffset = fHeader.runTableOffset + fHeader.nRuns * sizeof(EventListRunEntry);
+   fChecksum = eventListChecksum(fRuns.data(), fRuns.size() * sizeof(EventListRunEntry), fChecksum);
+   fChecksum = eventListChecksum(fLumis.data(), fLumis.size() * sizeof(EventListLumiEntry), fChecksum);
+   fHeader.checksum = fChecksum;
+   fHeader.sourceChecksum = sourceChecksum;
+
+   fOk = fOk && std::fwrite(fRuns.data(), sizeof(EventListRunEntry), fRuns.size(), fFile) == fRuns.size();
+   fOk = fOk && std::fwrite(fLumis.data(), sizeof(EventListLumiEntry), fLumis.size(), fFile) == fLumis.size();
+   fOk = fOk && std::fseek(fFile, 0, SEEK_SET) == 0;
+   fOk = fOk && std::fwrite(&fHeader, sizeof(fHeader), 1, fFile) == 1;
+   fOk = std::fclose(fFile) == 0 && fOk;
+   fFile = 0;
+   return fOk;
+}
+
+MappedEventList::MappedEventList()
+   : fMap(0), fSize(0), fHeader(0), fEvents(0), fRunTable(0), fLumiTable(0)
+{
+}
+
+MappedEventList::~MappedEventList()
+{
+   close();
+}
+
+void MappedEventList::close()
+{
+   if (fMap) munmap(fMap, fSize);
+   fMap = 0;
+   fSize = 0;
+   fHeader = 0;
+   fEvents = 0;
+   fRunTable = 0;
+   fLumiTable = 0;
+}
+
+bool MappedEventList::open(const std::string &path, bool verify)
+{
+   close();
+   int fd = ::open(path.c_str(), O_RDONLY);
+   if (fd < 0) {
+      fError = "cannot open " + path;
+      return false;
+   }
+   struct stat st;
+   if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(EventListFileHeader)) {
+      ::close(fd);
+      fError = path + " is too short to be an event list";
+      return false;
+   }
+   fSize = st.st_size;
+   fMap = mmap(0, fSize, PROT_READ, MAP_SHARED, fd, 0);
+   ::close(fd);
+   if (fMap == MAP_FAILED) {
+      fMap = 0;
+      fError = "cannot mmap " + path;
+      return false;
+   }
+
+   const EventListFileHeader *h = (const EventListFileHeader *)fMap;
+   if (std::memcmp(h->magic, kEventListMagic, sizeof(h->magic)) != 0 || h->version != kEventListVersion ||
+       h->headerSize != sizeof(EventListFileHeader)) {
+      close();
+      fError = path + " is not a version " + std::to_string(kEventListVersion) + " event list";
+      return false;
+   }
+   if (h->eventsOffset + h->nEvents * sizeof(Long64_t) != h->runTableOffset ||
+       h->runTableOffset + h->nRuns * sizeof(EventListRunEntry) != h->lumiTableOffset ||
+       h->lumiTableOffset + h->nLumis * sizeof(EventListLumiEntry) != fSize) {
+      close();
+      fError = path + " is truncated or corrupted";
+      return false;
+   }
+   if (verify) {
+      const char *base = (const char *)fMap;
+      ULong64_t sum = eventListChecksum(base + h->eventsOffset, fSize - h->eventsOffset);
+      if (sum != h->checksum) {
+         close();
+         fError = path + " has a bad checksum";
+         return false;
+      }
+   }
+
+   fHeader = h;
+   fEvents = (const Long64_t *)((const char *)fMap + h->eventsOffset);
+   fRunTable = (const EventListRunEntry *)((const char *)fMap + h->runTableOffset);
+   fLumiTable = (const EventListLumiEntry *)((const char *)fMap + h->lumiTableOffset);
+   madvise(fMap, fSize, MADV_RANDOM);
+   fError.clear();
+   return true;
+}
+
+size_t MappedEventList::findRun(Long64_t r) const
+{
+   const EventListRunEntry *end = fRunTable + nRuns();
+   const EventListRunEntry *it = std::lower_bound(fRunTable, end, r,
+      [](const EventListRunEntry &e, Long64_t value) { return e.run < value; });
+   return it != end && it->run == r ? it - fRunTable : nRuns();
+}
+
+void MappedEventList::adviseSequential()
+{
+   if (fMap) madvise(fMap, fSize, MADV_SEQUENTIAL);
+}
@@ -0,0 +1,227 @@
+#include "JetMETStudies/JMEAnalyzer/interface/EventListSetOps.h"
+#include <TFile.h>
+#include <TTree.h>
+#include <algorithm>
+#include <cstdio>
+#include <queue>
+#include <unistd.h>
+
+bool MappedEventListSource::open(const std::string &path)
+{
+   fRun = fPos = 0;
+   if (!fList.open(path)) return false;
+   fList.adviseSequential();
+   return true;
+}
+
+bool MappedEventListSource::next(Long64_t &run, Long64_t &event)
+{
+   while (fRun < fList.nRuns() && fPos == fList.nEvents(fRun)) {
+      ++fRun;
+      fPos = 0;
+   }
+   if (fRun == fList.nRuns()) return false;
+   run = fList.run(fRun);
+   event = fList.events(fRun)[fPos++];
+   return true;
+}
+
+void BinaryEventListSink::add(Long64_t run, Long64_t event)
+{
+   if (run != fRun || fEvents.size() == 4096) flush();
+   fRun = run;
+   fEvents.push_back(event);
+}
+
+void BinaryEventListSink::flush()
+{
+   fWriter.addRun(fRun, fEvents.data(), fEvents.size());
+   fEvents.clear();
+}
+
+bool BinaryEventListSink::close()
+{
+   flush();
+   return fWriter.close();
+}
+
+bool TextEventListSink::close()
+{
+   fOut.close();
+   return bool(fOut);
+}
+
+RootEventListSink::RootEventListSink(const std::string &path)
+   : fFile(TFile::Open(path.c_str(), "RECREATE")), fTree(0), fRun(0), fEvent(0), fLumi(-1)
+{
+   if (!fFile || fFile->IsZombie()) return;
+   fTree = new TTree("tree", "Event Summary");
+   fTree->Branch("event", &fEvent, "event/L");
+   fTree->Branch("run", &fRun, "run/L");
+   fTree->Branch("lumi", &fLumi, "lumi/L");
+}
+
+RootEventListSink::~RootEventListSink()
+{
+   delete fFile;
+}
+
+void RootEventListSink::add(Long64_t run, Long64_t event)
+{
+   fRun = run;
+   fEvent = event;
+   fTree->Fill();
+}
+
+bool RootEventListSink::close()
+{
+   if (!fTree) return false;
+   fFile->cd();
+   bool ok = fTree->Write() > 0;
+   fFile->Close();
+   return ok;
+}
+
+namespace {
+   // k-way merge: the head pair of every source on a min-heap
+   class EventListMerge {
+   public :
+      EventListMerge(const std::vector<EventListSource*> &sources, EventListSetOp op)
+         : fSources(sources), fOp(op), fDone(sources.size(), false)
+      {
+         for (size_t i = 0; i < fSources.size(); ++i) push(i);
+      }
+
+      // next pair of the result; false when there is none
+      bool next(Long64_t &run, Long64_t &event)
+      {
+         while (!fHeap.empty()) {
+            // nothing is left for the intersection once any source has ended,
+            // nor for the difference once the first one has
+            if (fOp == kEventListIntersection && fNDone > 0) return false;
+            if (fOp == kEventListDifference && fDone[0]) return false;
+
+            const Head top = fHeap.top();
+            size_t in = 0;
+            bool inFirst = false;
+            // pop every source standing on the same pair
+            while (!fHeap.empty() && fHeap.top().run == top.run && fHeap.top().event == top.event) {
+               const size_t i = fHeap.top().source;
+               fHeap.pop();
+               ++in;
+               inFirst = inFirst || i == 0;
+               push(i);
+            }
+            if (fOp == kEventListUnion || (fOp == kEventListIntersection && in == fSources.size()) ||
+                (fOp == kEventListDifference && inFirst && in == 1)) {
+               run = top.run;
+               event = top.event;
+               return true;
+            }
+         }
+         return false;
+      }
+
+   private :
+      struct Head {
+         Long64_t run;
+         Long64_t event;
+         size_t   source;
+         bool operator>(const Head &o) const { return run > o.run || (run == o.run && event > o.event); }
+      };
+
+      void push(size_t i)
+      {
+         Head h;
+         h.source = i;
+         if (fSources[i]->next(h.run, h.event)) {
+            fHeap.push(h);
+         } else if (!fDone[i]) {
+            fDone[i] = true;
+            ++fNDone;
+         }
+      }
+
+      std::vector<EventListSource*>                                    fSources;
+      EventListSetOp                                                   fOp;
+      std::vector<bool>                                                fDone;
+      size_t                                                           fNDone = 0;
+      std::priority_queue<Head, std::vector<Head>, std::greater<Head>> fHeap;
+   };
+
+   // union of the spilled chunks, itself a sorted source
+   class UnionSource : public EventListSource {
+   public :
+      explicit UnionSource(const std::vector<EventListSource*> &sources) : fMerge(sources, kEventListUnion) {}
+      bool next(Long64_t &run, Long64_t &event) override { return fMerge.next(run, event); }
+
+   private :
+      EventListMerge fMerge;
+   };
+}
+
+ULong64_t mergeEventLists(const std::vector<EventListSource*> &sources, EventListSetOp op, EventListSink &sink)
+{
+   if (sources.empty()) return 0;
+   EventListMerge merge(sources, op);
+   ULong64_t n = 0;
+   Long64_t run, event;
+   while (merge.next(run, event)) {
+      sink.add(run, event);
+      ++n;
+   }
+   return n;
+}
+
+SortedSpill::SortedSpill(const std::string &tmpDir, size_t chunkSize)
+   : fTmpDir(tmpDir), fChunkSize(chunkSize)
+{
+   fBuffer.reserve(std::min<size_t>(fChunkSize, 1 << 20));
+}
+
+void SortedSpill::add(Long64_t run, Long64_t event)
+{
+   if (!fError.empty()) return;
+   fBuffer.push_back(Pair{run, event});
+   if (fBuffer.size() >= fChunkSize) spill();
+}
+
+bool SortedSpill::spill()
+{
+   std::sort(fBuffer.begin(), fBuffer.end());
+   fBuffer.erase(std::unique(fBuffer.begin(), fBuffer.end()), fBuffer.end());
+   char name[64];
+   std::snprintf(name, sizeof(name), "/pickevents_spill_%d_%zu.pevl", int(getpid()), fChunks.size());
+   const std::string path = fTmpDir + name;
+   {
+      BinaryEventListSink sink(path);
+      for (const Pair &p : fBuffer) sink.add(p.run, p.event);
+      if (!sink.good() || !sink.close()) {
+         std::remove(path.c_str());
+         fError = "cannot write " + path;
+         return false;
+      }
+   }
+   std::unique_ptr<MappedEventListSource> chunk(new MappedEventListSource());
+   bool ok = chunk->open(path);
+   // the mapping outlives the name: nothing is left behind whatever happens next
+   std::remove(path.c_str());
+   if (!ok) {
+      fError = chunk->error();
+      return false;
+   }
+   fChunks.push_back(std::move(chunk));
+   fBuffer.clear();
+   return true;
+}
+
+EventListSource *SortedSpill::finish()
+{
+   if (!fBuffer.empty() && fError.empty()) spill();
+   std::vector<Pair>().swap(fBuffer);
+   if (!fError.empty()) return 0;
+   std::vector<EventListSource*> chunks;
+   for (auto &c : fChunks) chunks.push_back(c.get());
+   fSource.reset(new UnionSource(chunks));
+   return fSource.get();
+}
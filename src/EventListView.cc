@@ -0,0 +1,51 @@
+#include "JetMETStudies/JMEAnalyzer/interface/EventListView.h"
+
+size_t EventListView::findRun(Long64_t r) const
+{
+   size_t lo = 0, hi = nRuns();
+   while (lo < hi) {
+      size_t mid = (lo + hi) / 2;
+      if (run(mid) < r) lo = mid + 1;
+      else hi = mid;
+   }
+   return lo < nRuns() && run(lo) == r ? lo : nRuns();
+}
+
+size_t EventListView::totalEvents() const
+{
+   size_t n = 0;
+   for (size_t i = 0; i < nRuns(); ++i) n += nEvents(i);
+   return n;
+}
+
+MapEventListView::MapEventListView(const std::map<Long64_t, std::vector<Long64_t>> &run_to_event_map)
+{
+   fRuns.reserve(run_to_event_map.size());
+   fEvents.reserve(run_to_event_map.size());
+   for (auto &it : run_to_event_map) {
+      fRuns.push_back(it.first);
+      fEvents.push_back(&it.second);
+   }
+}
+
+OverlayEventListView::OverlayEventListView(const EventListView &base,
+                                           const std::map<Long64_t, std::vector<Long64_t>> &replaced)
+{
+   // both sorted by run: one merge, no event is copied
+   auto it = replaced.begin();
+   size_t i = 0;
+   while (i < base.nRuns() || it != replaced.end()) {
+      if (it != replaced.end() && (i == base.nRuns() || it->first <= base.run(i))) {
+         if (i < base.nRuns() && base.run(i) == it->first) ++i;
+         fRuns.push_back(it->first);
+         fEvents.push_back(it->second.data());
+         fNEvents.push_back(it->second.size());
+         ++it;
+      } else {
+         fRuns.push_back(base.run(i));
+         fEvents.push_back(base.events(i));
+         fNEvents.push_back(base.nEvents(i));
+         ++i;
+      }
+   }
+}
@@ -0,0 +1,64 @@
+#include "JetMETStudies/JMEAnalyzer/interface/EventSelection.h"
+#include "JetMETStudies/JMEAnalyzer/interface/PickEvents2.h"
+#include <algorithm>
+
+void EventSelection::add(Term t)
+{
+   t.nRejected = 0;
+   t.lastRun = -1;
+   t.lastLumi = -1;
+   t.lastIn = false;
+   fTerms.push_back(std::move(t));
+   fCompiled = false;
+}
+
+void EventSelection::addList(PickEvents2 *list, bool veto, const std::string &name)
+{
+   add(Term{kList, veto, name, nullptr, list});
+}
+
+void EventSelection::addLumiMask(std::shared_ptr<const IntervalMask> mask, bool veto, const std::string &name)
+{
+   add(Term{kLumiMask, veto, name, std::move(mask), nullptr});
+}
+
+void EventSelection::addEventRanges(std::shared_ptr<const IntervalMask> ranges, bool veto, const std::string &name)
+{
+   add(Term{kEventRanges, veto, name, std::move(ranges), nullptr});
+}
+
+void EventSelection::compile()
+{
+   // the kinds are declared cheapest first; ties keep the order given
+   std::stable_sort(fTerms.begin(), fTerms.end(), [](const Term &a, const Term &b) { return a.kind < b.kind; });
+   fCompiled = true;
+}
+
+bool EventSelection::Term::test(Long64_t run, Long64_t lumi, Long64_t event)
+{
+   switch (kind) {
+   case kLumiMask:
+      if (run != lastRun || lumi != lastLumi) {
+         lastRun = run;
+         lastLumi = lumi;
+         lastIn = mask->contains(run, lumi);
+      }
+      return lastIn;
+   case kEventRanges:
+      return mask->contains(run, event);
+   case kList:
+      return list->match(run, event);
+   }
+   return false;
+}
+
+void EventSelection::printStats(std::ostream &os) const
+{
+   static const char *kindNames[] = {"lumi mask", "event ranges", "list"};
+   os << "EventSelection: " << nAccepted << " of " << nEvents << " events accepted" << std::endl;
+   for (const Term &t : fTerms) {
+      os << "  " << (t.veto ? "veto " : "require ") << kindNames[t.kind] << " " << t.name;
+      if (t.mask) os << " (" << t.mask->size() << " intervals)";
+      os << ": rejected " << t.nRejected << std::endl;
+   }
+}
@@ -0,0 +1,47 @@
+#include "JetMETStudies/JMEAnalyzer/interface/FlatEventIndex.h"
+
+FlatEventIndex::FlatEventIndex() : fKeys(1), fN(0)
+{
+}
+
+FlatEventIndex::FlatEventIndex(const EventListView &list) : fN(0)
+{
+   // runs come in increasing order and events are sorted within a run,
+   // so the packed keys are already sorted
+   std::vector<Key> sorted;
+   sorted.reserve(list.totalEvents());
+   for (size_t i = 0; i < list.nRuns(); ++i) {
+      const Long64_t *events = list.events(i);
+      for (size_t j = 0; j < list.nEvents(i); ++j) sorted.push_back(pack(list.run(i), events[j]));
+   }
+
+   fN = sorted.size();
+   fKeys.assign(fN + 1, Key(0));
+   fill(sorted, 0, 1);
+}
+
+size_t FlatEventIndex::fill(const std::vector<Key> &sorted, size_t i, size_t k)
+{
+   // in-order walk of the implicit tree assigns the sorted keys
+   if (k <= fN) {
+      i = fill(sorted, i, 2 * k);
+      fKeys[k] = sorted[i++];
+      i = fill(sorted, i, 2 * k + 1);
+   }
+   return i;
+}
+
+bool FlatEventIndex::contains(Long64_t run, Long64_t event) const
+{
+   const Key key = pack(run, event);
+   const Key *base = fKeys.data();
+   size_t k = 1;
+   while (k <= fN) {
+      // 4 keys per cache line: fetch the grandchildren two levels ahead
+      __builtin_prefetch(base + 4 * k);
+      k = 2 * k + (base[k] < key);
+   }
+   // undo the trailing right turns to land on the lower bound
+   k >>= __builtin_ffsll(~k);
+   return k != 0 && base[k] == key;
+}
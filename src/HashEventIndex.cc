@@ -0,0 +1,90 @@
+#include "JetMETStudies/JMEAnalyzer/interface/HashEventIndex.h"
+
+namespace {
+   // tables are kept at most half full
+   size_t tableCapacity(size_t n)
+   {
+      size_t cap = 2;
+      while (cap < 2 * n) cap <<= 1;
+      return cap;
+   }
+}
+
+HashEventIndex::HashEventIndex()
+   : fRuns(1, RunSlot{kEmpty, 0, 0}), fNRuns(0), fN(0), fProbeSum(0), fProbeMax(0)
+{
+}
+
+HashEventIndex::HashEventIndex(const EventListView &list)
+   : fNRuns(list.nRuns()), fN(0), fProbeSum(0), fProbeMax(0)
+{
+   size_t nslots = 0;
+   for (size_t ir = 0; ir < list.nRuns(); ++ir) nslots += tableCapacity(list.nEvents(ir));
+   fSlots.assign(nslots, kEmpty);
+   fRuns.assign(tableCapacity(list.nRuns()), RunSlot{kEmpty, 0, 0});
+
+   const size_t rmask = fRuns.size() - 1;
+   size_t offset = 0;
+   for (size_t ir = 0; ir < list.nRuns(); ++ir) {
+      const size_t cap = tableCapacity(list.nEvents(ir));
+      size_t r = hash(list.run(ir)) & rmask;
+      while (fRuns[r].run != kEmpty) r = (r + 1) & rmask;
+      fRuns[r] = RunSlot{list.run(ir), offset, cap - 1};
+
+      Long64_t *table = &fSlots[offset];
+      const Long64_t *events = list.events(ir);
+      for (size_t j = 0; j < list.nEvents(ir); ++j) {
+         const Long64_t event = events[j];
+         size_t i = hash(event) & (cap - 1);
+         size_t probes = 1;
+         while (table[i] != kEmpty && table[i] != event) {
+            i = (i + 1) & (cap - 1);
+            ++probes;
+         }
+         if (table[i] == event) continue; // duplicate entry in the list
+         table[i] = event;
+         ++fN;
+         fProbeSum += probes;
+         if (probes > fProbeMax) fProbeMax = probes;
+      }
+      offset += cap;
+   }
+}
+
+const HashEventIndex::RunSlot *HashEventIndex::findRun(Long64_t run) const
+{
+   const size_t rmask = fRuns.size() - 1;
+   size_t r = hash(run) & rmask;
+   while (fRuns[r].run != run) {
+      if (fRuns[r].run == kEmpty) return 0;
+      r = (r + 1) & rmask;
+   }
+   return &fRuns[r];
+}
+
+bool HashEventIndex::contains(Long64_t run, Long64_t event) const
+{
+   const RunSlot *rs = findRun(run);
+   if (!rs) return false;
+   const Long64_t *table = fSlots.data() + rs->offset;
+   size_t i = hash(event) & rs->mask;
+   while (table[i] != event) {
+      if (table[i] == kEmpty) return false;
+      i = (i + 1) & rs->mask;
+   }
+   return true;
+}
+
+size_t HashEventIndex::bytes() const
+{
+   return fRuns.capacity() * sizeof(RunSlot) + fSlots.capacity() * sizeof(Long64_t);
+}
+
+void HashEventIndex::printStats(std::ostream &os) const
+{
+   EventIndex::printStats(os);
+   os << "  runs: " << fNRuns << "\n"
+      << "  load factor: " << loadFactor() << "\n"
+      << "  mean probe length: " << meanProbeLength() << "\n"
+      << "  max probe length: " << maxProbeLength() << "\n";
+}
@@ -0,0 +1,170 @@
+#include "JetMETStudies/JMEAnalyzer/interface/IntervalMask.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+IntervalMask::IntervalMask(std::vector<Interval> intervals)
+{
+   add(std::move(intervals));
+}
+
+void IntervalMask::add(std::vector<Interval> intervals)
+{
+   intervals.insert(intervals.end(), fIntervals.begin(), fIntervals.end());
+   std::sort(intervals.begin(), intervals.end(),
+             [](const Interval &a, const Interval &b) { return a.first < b.first; });
+   fIntervals.clear();
+   for (const Interval &in : intervals) {
+      if (in.last < in.first) continue;
+      // overlapping, or next lumi/event of the same run
+      if (!fIntervals.empty()) {
+         Interval &back = fIntervals.back();
+         if (!(back.last < in.first) ||
+             (back.last.run == in.first.run && back.last.value != kMaxValue && back.last.value + 1 == in.first.value)) {
+            if (back.last < in.last) back.last = in.last;
+            continue;
+         }
+      }
+      fIntervals.push_back(in);
+   }
+}
+
+bool IntervalMask::contains(Long64_t run, Long64_t value) const
+{
+   const Point p{run, value};
+   // last interval starting at or before p
+   auto it = std::upper_bound(fIntervals.begin(), fIntervals.end(), p,
+                              [](const Point &q, const Interval &in) { return q < in.first; });
+   if (it == fIntervals.begin()) return false;
+   --it;
+   return !(it->last < p);
+}
+
+bool IntervalMask::hasRun(Long64_t run) const
+{
+   // first interval ending in the run or after it
+   const Point begin{run, std::numeric_limits<Long64_t>::min()};
+   auto it = std::lower_bound(fIntervals.begin(), fIntervals.end(), begin,
+                              [](const Interval &in, const Point &q) { return in.last < q; });
+   return it != fIntervals.end() && it->first.run <= run;
+}
+
+namespace {
+   // minimal reader for the lumi-mask JSON: an object of string keys
+   // holding arrays of two-number arrays
+   struct JsonCursor {
+      const char *p, *end;
+
+      void skipSpace()
+      {
+         while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+      }
+      bool expect(char c)
+      {
+         skipSpace();
+         if (p == end || *p != c) return false;
+         ++p;
+         return true;
+      }
+      bool peek(char c)
+      {
+         skipSpace();
+         return p < end && *p == c;
+      }
+      bool number(Long64_t &v)
+      {
+         skipSpace();
+         auto res = std::from_chars(p, end, v);
+         if (res.ec != std::errc()) return false;
+         p = res.ptr;
+         return true;
+      }
+   };
+}
+
+bool IntervalMask::parseLumiJson(const std::string &text)
+{
+   JsonCursor c{text.data(), text.data() + text.size()};
+   std::vector<Interval> intervals;
+   if (!c.expect('{')) {
+      fError = "lumi mask is not a JSON object";
+      return false;
+   }
+   bool first = true;
+   while (!c.peek('}')) {
+      Long64_t run = 0;
+      if ((!first && !c.expect(',')) || !c.expect('"') || !c.number(run) || !c.expect('"') || !c.expect(':') ||
+          !c.expect('[')) {
+         fError = "malformed lumi mask at offset " + std::to_string(c.p - text.data());
+         return false;
+      }
+      first = false;
+      bool firstRange = true;
+      while (!c.peek(']')) {
+         Long64_t a = 0, b = 0;
+         if ((!firstRange && !c.expect(',')) || !c.expect('[') || !c.number(a) || !c.expect(',') || !c.number(b) ||
+             !c.expect(']')) {
+            fError = "malformed lumi range in run " + std::to_string(run);
+            return false;
+         }
+         firstRange = false;
+         intervals.push_back(Interval{Point{run, a}, Point{run, b}});
+      }
+      c.expect(']');
+   }
+   c.expect('}');
+   add(std::move(intervals));
+   return true;
+}
+
+bool IntervalMask::loadLumiJson(const std::string &path)
+{
+   std::ifstream in(path.c_str());
+   if (!in) {
+      fError = "cannot open " + path;
+      return false;
+   }
+   std::ostringstream text;
+   text << in.rdbuf();
+   if (!parseLumiJson(text.str())) {
+      fError = path + ": " + fError;
+      return false;
+   }
+   return true;
+}
+
+// "run" or "run:value"; a bare run stands for all its values, from or to
+static bool parsePoint(const char *p, const char *end, bool isLast, IntervalMask::Point &out)
+{
+   auto res = std::from_chars(p, end, out.run);
+   if (res.ec != std::errc()) return false;
+   if (res.ptr == end) {
+      out.value = isLast ? IntervalMask::kMaxValue : std::numeric_limits<Long64_t>::min();
+      return true;
+   }
+   if (*res.ptr != ':') return false;
+   res = std::from_chars(res.ptr + 1, end, out.value);
+   return res.ec == std::errc() && res.ptr == end;
+}
+
+bool IntervalMask::addRanges(const std::vector<std::string> &ranges)
+{
+   std::vector<Interval> intervals;
+   for (const std::string &r : ranges) {
+      const char *begin = r.data(), *end = r.data() + r.size();
+      const char *dash = (const char *)std::memchr(begin, '-', r.size());
+      Interval in;
+      bool ok = dash ? parsePoint(begin, dash, false, in.first) && parsePoint(dash + 1, end, true, in.last)
+                     : parsePoint(begin, end, false, in.first) && parsePoint(begin, end, true, in.last);
+      if (!ok || in.last < in.first) {
+         fError = "bad range '" + r + "', expected run:event-run:event";
+         return false;
+      }
+      intervals.push_back(in);
+   }
+   add(std::move(intervals));
+   return true;
+}
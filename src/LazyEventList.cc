@@ -0,0 +1,204 @@
+#include "JetMETStudies/JMEAnalyzer/interface/LazyEventList.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+#include <TChain.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char   kRunIndexMagic[4] = {'P', 'E', 'R', 'I'};
+static const UInt_t kRunIndexVersion = 1;
+
+LazyEventList::LazyEventList(const std::vector<std::string> &files, const std::string &treeName,
+                             const std::string &cacheDir)
+   : fFiles(files), fTreeName(treeName), fCacheDir(cacheDir), fEntries(0), fIndexSeconds(0),
+     fIndexFromCache(false), fEvent(0), fEntriesRead(0), fBytesRead(0)
+{
+   if (fCacheDir.empty()) fCacheDir = std::getenv("PICKEVENTS_CACHE") ? std::getenv("PICKEVENTS_CACHE") : "/tmp";
+}
+
+LazyEventList::~LazyEventList()
+{
+}
+
+std::string LazyEventList::indexPath() const
+{
+   // the files as they are now: any rewrite gives another key. Files that
+   // cannot be stat'ed (remote) are not cached.
+   ULong64_t key = eventListChecksum(fTreeName.data(), fTreeName.size());
+   for (const std::string &f : fFiles) {
+      struct stat st;
+      if (::stat(f.c_str(), &st) != 0) return "";
+      const Long64_t id[2] = {Long64_t(st.st_size), Long64_t(st.st_mtime)};
+      key = eventListChecksum(f.data(), f.size(), key);
+      key = eventListChecksum(id, sizeof(id), key);
+   }
+   char name[64];
+   std::snprintf(name, sizeof(name), "/pickevents_runs_%016llx.peri", (unsigned long long)key);
+   return fCacheDir + name;
+}
+
+bool LazyEventList::readIndex(const std::string &path)
+{
+   FILE *f = std::fopen(path.c_str(), "rb");
+   if (!f) return false;
+   char magic[4];
+   UInt_t version = 0;
+   ULong64_t n = 0;
+   bool ok = std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, kRunIndexMagic, 4) == 0 &&
+             std::fread(&version, sizeof(version), 1, f) == 1 && version == kRunIndexVersion &&
+             std::fread(&n, sizeof(n), 1, f) == 1;
+   std::vector<Long64_t> table(3 * n);
+   ok = ok && std::fread(table.data(), sizeof(Long64_t), table.size(), f) == table.size();
+   std::fclose(f);
+   if (!ok) return false;
+   fRanges.clear();
+   fEntries = 0;
+   for (ULong64_t i = 0; i < n; ++i) {
+      fRanges[table[3 * i]].push_back(Range{table[3 * i + 1], table[3 * i + 2]});
+      fEntries = std::max(fEntries, table[3 * i + 2]);
+   }
+   return true;
+}
+
+bool LazyEventList::writeIndex(const std::string &path) const
+{
+   std::vector<Long64_t> table;
+   for (auto &it : fRanges) {
+      for (const Range &r : it.second) {
+         table.push_back(it.first);
+         table.push_back(r.first);
+         table.push_back(r.last);
+      }
+   }
+   const ULong64_t n = table.size() / 3;
+   // written aside and renamed: a concurrent job never reads half a file
+   const std::string tmp = path + "." + std::to_string(getpid());
+   FILE *f = std::fopen(tmp.c_str(), "wb");
+   if (!f) return false;
+   bool ok = std::fwrite(kRunIndexMagic, 1, 4, f) == 4 && std::fwrite(&kRunIndexVersion, sizeof(UInt_t), 1, f) == 1 &&
+             std::fwrite(&n, sizeof(n), 1, f) == 1 &&
+             std::fwrite(table.data(), sizeof(Long64_t), table.size(), f) == table.size();
+   ok = std::fclose(f) == 0 && ok;
+   if (ok) ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+   if (!ok) std::remove(tmp.c_str());
+   return ok;
+}
+
+bool LazyEventList::buildIndex()
+{
+   // the run column alone, through a cache on that branch
+   Long64_t run = 0;
+   fChain->SetBranchStatus("*", 0);
+   fChain->SetBranchStatus("run", 1);
+   if (fChain->SetBranchAddress("run", &run) < 0) {
+      fError = "no branch 'run' in the list tree";
+      return false;
+   }
+   fChain->SetCacheSize(-1);
+   fChain->AddBranchToCache("run", kTRUE);
+   fRanges.clear();
+   fEntries = fChain->GetEntries();
+   // runs are mostly contiguous in a list: one range per stretch
+   Long64_t current = 0, first = 0;
+   for (Long64_t entry = 0; entry < fEntries; ++entry) {
+      if (fChain->GetEntry(entry) <= 0) {
+         fError = "cannot read entry " + std::to_string(entry) + " of the list tree";
+         return false;
+      }
+      if (entry > 0 && run != current) {
+         fRanges[current].push_back(Range{first, entry});
+         first = entry;
+      }
+      current = run;
+   }
+   if (fEntries > 0) fRanges[current].push_back(Range{first, fEntries});
+   fChain->ResetBranchAddresses();
+   return true;
+}
+
+bool LazyEventList::open()
+{
+   auto start = std::chrono::steady_clock::now();
+   fChain.reset(new TChain(fTreeName.c_str()));
+   for (const std::string &f : fFiles) fChain->Add(f.c_str());
+
+   const std::string path = indexPath();
+   fIndexFromCache = !path.empty() && readIndex(path);
+   if (!fIndexFromCache) {
+      if (!buildIndex()) return false;
+      if (!path.empty()) writeIndex(path);
+   }
+
+   // from now on only the event column is read
+   fChain->SetBranchStatus("*", 0);
+   fChain->SetBranchStatus("event", 1);
+   if (fChain->SetBranchAddress("event", &fEvent) < 0) {
+      fError = "no branch 'event' in the list tree";
+      return false;
+   }
+   fIndexSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   return true;
+}
+
+std::shared_ptr<LazyEventList> LazyEventList::shared(const std::vector<std::string> &files,
+                                                     const std::string &treeName, const std::string &cacheDir)
+{
+   static std::mutex cache_mutex;
+   static std::map<std::string, std::weak_ptr<LazyEventList>> cache;
+
+   std::string key = treeName;
+   for (const std::string &f : files) key += ":" + f;
+   std::lock_guard<std::mutex> lock(cache_mutex);
+   if (auto live = cache[key].lock()) return live;
+   std::shared_ptr<LazyEventList> list(new LazyEventList(files, treeName, cacheDir));
+   if (!list->open()) {
+      std::cerr << "LazyEventList: " << list->error() << std::endl;
+      return std::shared_ptr<LazyEventList>();
+   }
+   cache[key] = list;
+   return list;
+}
+
+const std::vector<Long64_t> *LazyEventList::events(Long64_t run)
+{
+   auto ranges = fRanges.find(run);
+   if (ranges == fRanges.end()) return 0;
+
+   std::lock_guard<std::mutex> lock(fMutex);
+   auto it = fLoaded.find(run);
+   if (it != fLoaded.end()) return &it->second;
+   std::vector<Long64_t> &events = fLoaded[run];
+   for (const Range &r : ranges->second) {
+      for (Long64_t entry = r.first; entry < r.last; ++entry) {
+         fBytesRead += fChain->GetEntry(entry);
+         events.push_back(fEvent);
+      }
+      fEntriesRead += r.last - r.first;
+   }
+   std::sort(events.begin(), events.end());
+   events.erase(std::unique(events.begin(), events.end()), events.end());
+   return &events;
+}
+
+size_t LazyEventList::nRunsLoaded() const
+{
+   std::lock_guard<std::mutex> lock(fMutex);
+   return fLoaded.size();
+}
+
+ULong64_t LazyEventList::entriesRead() const
+{
+   std::lock_guard<std::mutex> lock(fMutex);
+   return fEntriesRead;
+}
+
+Long64_t LazyEventList::bytesRead() const
+{
+   std::lock_guard<std::mutex> lock(fMutex);
+   return fBytesRead;
+}
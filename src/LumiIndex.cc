@@ -0,0 +1,86 @@
+#include "JetMETStudies/JMEAnalyzer/interface/LumiIndex.h"
+#include <algorithm>
+
+LumiIndex::LumiIndex(std::vector<ULong64_t> keys)
+{
+   std::sort(keys.begin(), keys.end());
+   for (size_t i = 0; i < keys.size();) {
+      size_t j = i;
+      while (j < keys.size() && keys[j] == keys[i]) ++j;
+      fKeys.push_back(keys[i]);
+      fCounts.push_back(j - i);
+      i = j;
+   }
+}
+
+LumiIndex::LumiIndex(const LumiIndex &base, std::vector<ULong64_t> keys)
+{
+   const LumiIndex added(std::move(keys));
+   size_t i = 0, j = 0;
+   while (i < base.size() || j < added.size()) {
+      if (j == added.size() || (i < base.size() && base.fKeys[i] < added.fKeys[j])) {
+         fKeys.push_back(base.fKeys[i]);
+         fCounts.push_back(base.fCounts[i++]);
+      } else if (i == base.size() || added.fKeys[j] < base.fKeys[i]) {
+         fKeys.push_back(added.fKeys[j]);
+         fCounts.push_back(added.fCounts[j++]);
+      } else {
+         fKeys.push_back(base.fKeys[i]);
+         fCounts.push_back(base.fCounts[i++] + added.fCounts[j++]);
+      }
+   }
+}
+
+LumiIndex::LumiIndex(const EventListLumiEntry *table, size_t n)
+{
+   fKeys.reserve(n);
+   fCounts.reserve(n);
+   for (size_t i = 0; i < n; ++i) {
+      fKeys.push_back(table[i].key);
+      fCounts.push_back(table[i].count);
+   }
+}
+
+ULong64_t LumiIndex::eventCount(Long64_t run, Long64_t lumi) const
+{
+   const ULong64_t key = pack(run, lumi);
+   auto it = std::lower_bound(fKeys.begin(), fKeys.end(), key);
+   if (it == fKeys.end() || *it != key) return 0;
+   return fCounts[it - fKeys.begin()];
+}
+
+std::vector<LumiIndex::Range> LumiIndex::ranges() const
+{
+   std::vector<Range> out;
+   for (ULong64_t key : fKeys) {
+      const Long64_t run = key >> 32, lumi = key & 0xffffffffULL;
+      if (!out.empty() && out.back().run == run && out.back().lastLumi + 1 == lumi)
+         out.back().lastLumi = lumi;
+      else
+         out.push_back(Range{run, lumi, lumi});
+   }
+   return out;
+}
+
+void LumiIndex::writeRanges(std::ostream &os, bool json) const
+{
+   const std::vector<Range> rs = ranges();
+   if (json) {
+      os << "{";
+      for (size_t i = 0; i < rs.size(); ++i) {
+         if (i == 0 || rs[i].run != rs[i - 1].run)
+            os << (i ? "], " : "") << "\"" << rs[i].run << "\": [";
+         else
+            os << ", ";
+         os << "[" << rs[i].firstLumi << ", " << rs[i].lastLumi << "]";
+      }
+      os << (rs.empty() ? "}" : "]}") << "\n";
+      return;
+   }
+   os << "import FWCore.ParameterSet.Config as cms\n\n"
+      << "lumisToProcess = cms.untracked.VLuminosityBlockRange()\n"
+      << "lumisToProcess.extend([\n";
+   for (const Range &r : rs)
+      os << "   \"" << r.run << ":" << r.firstLumi << "-" << r.run << ":" << r.lastLumi << "\",\n";
+   os << "])\n";
+}
@@ -0,0 +1,17 @@
+#include "JetMETStudies/JMEAnalyzer/interface/MappedEventIndex.h"
+#include <algorithm>
+
+bool MappedEventIndex::contains(Long64_t run, Long64_t event) const
+{
+   const size_t i = fList.findRun(run);
+   if (i == fList.nRuns()) return false;
+   const Long64_t *events = fList.events(i);
+   return std::binary_search(events, events + fList.nEvents(i), event);
+}
+
+void MappedEventIndex::printStats(std::ostream &os) const
+{
+   EventIndex::printStats(os);
+   os << "  runs: " << fList.nRuns() << "\n"
+      << "  mapped bytes: " << fList.mappedBytes() << "\n";
+}
@@ -0,0 +1,8 @@
+#include "JetMETStudies/JMEAnalyzer/interface/OverlayEventIndex.h"
+
+void OverlayEventIndex::printStats(std::ostream &os) const
+{
+   fBase.printStats(os);
+   os << "  appended events: " << fAdded->size() << "\n"
+      << "  appended bytes: " << fAdded->bytes() << "\n";
+}
@@ -1,5 +1,9 @@
 #define PickEvents2_cxx
 #include "JetMETStudies/JMEAnalyzer/interface/PickEvents2.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventBloomFilter.h"
+#include "JetMETStudies/JMEAnalyzer/interface/LumiIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+#include "JetMETStudies/JMEAnalyzer/interface/TextEventList.h"
 #include <TH2.h>
 #include <TStyle.h>
 #include <TCanvas.h>
@@ -8,13 +12,115 @@
 #include <assert.h>
 #include <TMath.h>
 #include <iostream>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <TChain.h>
+#include <TChainElement.h>
+#include <ROOT/TThreadExecutor.hxx>
 //using namespace std;
 
-std::vector<Long64_t> list_runs; 
-//... so we want to group the first 4 events with the same run
-std::vector<Long64_t> list_events;
+//files the tree or chain reads from
+static std::vector<std::string> treeFiles(TTree *tree)
+{
+   std::vector<std::string> files;
+   if (TChain *chain = dynamic_cast<TChain*>(tree)) {
+      TObjArray *elements = chain->GetListOfFiles();
+      for (Int_t i = 0; i < elements->GetEntriesFast(); i++) files.push_back(elements->At(i)->GetTitle());
+   } else if (tree->GetCurrentFile()) {
+      files.push_back(tree->GetCurrentFile()->GetName());
+   }
+   return files;
+}
+
+// only the run/event/lumi branches are read, through a tree cache on just those
+static void readIdColumnsOnly(TTree *tree)
+{
+   tree->SetBranchStatus("*", 0);
+   tree->SetBranchStatus("run", 1);
+   tree->SetBranchStatus("event", 1);
+   tree->SetBranchStatus("lumi", 1);
+   tree->SetCacheSize(-1);
+   tree->AddBranchToCache("run", kTRUE);
+   tree->AddBranchToCache("event", kTRUE);
+   tree->AddBranchToCache("lumi", kTRUE);
+}
+
+// entries [first, last) of the tree in one file
+struct ClusterRange {
+   std::string file;
+   Long64_t    first, last;
+};
+
+// each file of the chain cut at cluster boundaries into about nTasks ranges;
+// false if a file or its tree cannot be read
+static bool clusterRanges(TTree *chain, UInt_t nTasks, std::vector<ClusterRange> &ranges)
+{
+   const std::string treeName = chain->GetName();
+   for (const std::string &path : treeFiles(chain)) {
+      std::unique_ptr<TFile> file(TFile::Open(path.c_str(), "READ"));
+      TTree *tree = 0;
+      if (file && !file->IsZombie()) file->GetObject(treeName.c_str(), tree);
+      if (!tree) {
+         std::cerr << "PickEvents2: no tree " << treeName << " in " << path << std::endl;
+         return false;
+      }
+      const Long64_t n = tree->GetEntries();
+      const Long64_t step = (n + nTasks - 1) / nTasks;
+      TTree::TClusterIterator clusters = tree->GetClusterIterator(0);
+      Long64_t first = 0;
+      while (clusters.Next() < n) {
+         const Long64_t end = std::min(clusters.GetNextEntry(), n);
+         if (end - first >= step || end == n) {
+            ranges.push_back(ClusterRange{path, first, end});
+            first = end;
+         }
+      }
+   }
+   return true;
+}
+
+// reads one range with its own file and tree, calling fill(run, event, lumi)
+// per entry in entry order, with lumi -1 if the tree has no lumi branch;
+// returns the bytes read, or -1 if the file, the tree or the run/event
+// branches cannot be read (the entries filled so far are then not the whole
+// range)
+template <class Fill>
+static Long64_t readRange(const std::string &treeName, const ClusterRange &range, Fill fill)
+{
+   std::unique_ptr<TFile> file(TFile::Open(range.file.c_str(), "READ"));
+   TTree *tree = 0;
+   if (file && !file->IsZombie()) file->GetObject(treeName.c_str(), tree);
+   if (!tree) return -1;
+   Long64_t r = 0, e = 0, l = -1;
+   TBranch *br = 0, *be = 0, *bl = 0;
+   readIdColumnsOnly(tree);
+   tree->SetBranchAddress("run", &r, &br);
+   tree->SetBranchAddress("event", &e, &be);
+   if (tree->GetBranch("lumi")) tree->SetBranchAddress("lumi", &l, &bl);
+   if (!br || !be) return -1;
+   Long64_t nbytes = 0;
+   for (Long64_t i = range.first; i < range.last; ++i) {
+      const Int_t nr = br->GetEntry(i), ne = be->GetEntry(i), nl = bl ? bl->GetEntry(i) : 0;
+      if (nr < 0 || ne < 0 || nl < 0) return -1;
+      nbytes += nr + ne + nl;
+      fill(r, e, l);
+   }
+   return nbytes;
+}
+
+bool PickEvents2::backendFromName(const std::string &name, IndexBackend &backend)
+{
+   PickEventsIndex::Backend b;
+   if (!PickEventsIndex::backendFromName(name, b)) return false;
+   backend = IndexBackend(b);
+   return true;
+}
 
-std::map<Long64_t, std::vector<Long64_t>> run_to_event_map;
+PickEventsIndex::Options PickEvents2::indexOptions() const
+{
+   return PickEventsIndex::Options(PickEventsIndex::Backend(backend), prefilterFPR, nLoadThreads);
+}
 
 void PickEvents2::Loop()
 {
@@ -41,49 +147,266 @@ void PickEvents2::Loop()
 // METHOD2: replace line
 //    fChain->GetEntry(jentry);       //read all branches
 //by  b_branchname->GetEntry(ientry); //read only this branch
-  if (! first ) return;
+   if (fChain == 0) OpenDefaultList();
    if (fChain == 0) return;
-   first = false;
 
+   // the list is identified by its files and tree name
+   std::string key = "tree:" + std::string(fChain->GetName());
+   for (const std::string &f : treeFiles(fChain)) key += ":" + f;
+   const PickEventsIndex::Options options = indexOptions();
+   reloader.reset();
+   lazy.reset();
+   cursor.reset();
+   index = PickEventsIndex::shared(key + "|" + options.key(), [&]() {
+      auto start = std::chrono::steady_clock::now();
+      std::shared_ptr<PickEventsIndex> built;
+      Long64_t nbytes = 0;
+      if (options.backend == PickEventsIndex::kCompressed) {
+         // the list goes into compressed blocks as it is read, never held raw
+         PickEventsIndex::Stream stream(options);
+         nbytes = LoadStream(stream);
+         built = stream.finish();
+      } else {
+         std::vector<Long64_t> runs, events, lumis;
+         nbytes = nLoadThreads > 1 ? LoadColumnsMT(runs, events, lumis) : LoadColumns(runs, events, lumis);
+         assert(runs.size() == events.size() );
+         built = PickEventsIndex::fromColumns(runs, events, lumis, options);
+      }
+      built->loadBytes = nbytes;
+      built->loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return PickEventsIndex::Ptr(built);
+   });
+}
+
+bool PickEvents2::LoadText(const std::vector<std::string> &files)
+{
+   std::string key = "text";
+   for (const std::string &f : files) key += ":" + f;
+   const PickEventsIndex::Options options = indexOptions();
+   reloader.reset();
+   lazy.reset();
+   cursor.reset();
+   index = PickEventsIndex::shared(key + "|" + options.key(), [&]() {
+      auto start = std::chrono::steady_clock::now();
+      TextEventList text;
+      if (!text.load(files, nLoadThreads)) {
+         std::cerr << "PickEvents2: " << text.error() << std::endl;
+         return PickEventsIndex::Ptr();
+      }
+      if (text.badLines())
+         std::cerr << "PickEvents2: skipped " << text.badLines() << " malformed lines in text event lists" << std::endl;
+      TextEventList::Columns &columns = text.columns();
+      auto built = PickEventsIndex::fromColumns(columns.runs, columns.events, columns.lumis, options);
+      built->loadBytes = text.bytesRead();
+      built->loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return PickEventsIndex::Ptr(built);
+   });
+   return bool(index);
+}
+
+bool PickEvents2::Watch(const std::vector<std::string> &files, double pollSeconds)
+{
+   if (files.empty() && fChain == 0) OpenDefaultList();
+   lazy.reset();
+   reloader.reset(new PickEventsReloader(files.empty() && fChain ? treeFiles(fChain) : files, indexOptions()));
+   if (!reloader->load()) {
+      reloader.reset();
+      return false;
+   }
+   // the first index counts as loaded, not reloaded
+   reloadGeneration = reloader->generation();
+   index = reloader->current();
+   cursor.reset();
+   if (pollSeconds > 0) reloader->start(pollSeconds);
+   return true;
+}
+
+bool PickEvents2::LoadEmbedded(const std::string &name)
+{
+   reloader.reset();
+   lazy.reset();
+   cursor.reset();
+   const EmbeddedEventList *list = EmbeddedEventList::find(name);
+   if (!list) {
+      std::cerr << "PickEvents2: no embedded event list '" << name << "' in this program" << std::endl;
+      index.reset();
+      return false;
+   }
+   index = PickEventsIndex::shared("embedded:" + name, [list]() { return PickEventsIndex::Ptr(PickEventsIndex::fromEmbedded(*list)); });
+   return true;
+}
+
+bool PickEvents2::LoadLazy(const std::string &cacheDir)
+{
+   if (fChain == 0) OpenDefaultList();
+   if (fChain == 0) return false;
+   reloader.reset();
+   index.reset();
+   cursor.reset();
+   lazy = LazyEventList::shared(treeFiles(fChain), fChain->GetName(), cacheDir);
+   return bool(lazy);
+}
+
+Long64_t PickEvents2::LoadColumns(std::vector<Long64_t> &runs, std::vector<Long64_t> &events, std::vector<Long64_t> &lumis)
+{
+   readIdColumnsOnly(fChain);
    Long64_t nentries = fChain->GetEntriesFast();
-   list_runs.clear();
-   list_events.clear();
-   run_to_event_map.clear();
-   Long64_t nbytes = 0, nb = 0;
+   runs.reserve(nentries);
+   events.reserve(nentries);
+   lumis.reserve(nentries);
+   Long64_t nbytes = 0;
    for (Long64_t jentry=0; jentry < nentries; jentry++) {
       Long64_t ientry = LoadTree(jentry);
       if (ientry < 0) break;
-      nb = fChain->GetEntry(jentry);   
-      nbytes += nb;
-      // if (Cut(ientry) < 0) continue;
-      //list_runs.push_back(run);
-      //list_events.push_back(event);
-      // std::cout << "run: " << run << endl;
-      assert(list_runs.size() == list_events.size() );
-      if (run_to_event_map.find(run) == run_to_event_map.end() ) {
-	run_to_event_map[run] = std::vector<Long64_t>();
-      }
-      run_to_event_map[run].push_back(event);
+      nbytes += b_run->GetEntry(ientry);
+      nbytes += b_event->GetEntry(ientry);
+      // b_lumi follows the current file of the chain, null where it has
+      // no lumi branch: those events get lumi -1, unknown to PickEventsIndex
+      if (b_lumi) nbytes += b_lumi->GetEntry(ientry);
+      else lumi = -1;
+      runs.push_back(run);
+      events.push_back(event);
+      lumis.push_back(lumi);
+   }
+   return nbytes;
+}
+
+Long64_t PickEvents2::LoadColumnsMT(std::vector<Long64_t> &runs, std::vector<Long64_t> &events, std::vector<Long64_t> &lumis)
+{
+   // one task per cluster range, each with its own file and tree. The
+   // caller's ROOT setup is left alone: no implicit MT, only the thread
+   // safety that concurrent TFile reads need (idempotent, already on in cmsRun)
+   ROOT::EnableThreadSafety();
+   const std::string treeName = fChain->GetName();
+   // a range that cannot be read would silently drop part of the list: any
+   // failure reads the whole list again serially, through fChain
+   std::vector<ClusterRange> ranges;
+   if (!clusterRanges(fChain, nLoadThreads, ranges)) {
+      std::cerr << "PickEvents2: reading the list serially" << std::endl;
+      return LoadColumns(runs, events, lumis);
    }
 
+   struct Columns {
+      std::vector<Long64_t> runs, events, lumis;
+      Long64_t nbytes;
+   };
+   std::vector<Columns> parts(ranges.size());
+   std::vector<size_t> tasks(ranges.size());
+   for (size_t i = 0; i < tasks.size(); ++i) tasks[i] = i;
+   ROOT::TThreadExecutor(nLoadThreads).Foreach([&](size_t i) {
+      Columns &part = parts[i];
+      const size_t n = ranges[i].last - ranges[i].first;
+      part.runs.reserve(n);
+      part.events.reserve(n);
+      part.lumis.reserve(n);
+      part.nbytes = readRange(treeName, ranges[i], [&part](Long64_t r, Long64_t e, Long64_t l) {
+         part.runs.push_back(r);
+         part.events.push_back(e);
+         part.lumis.push_back(l);
+      });
+   }, tasks);
+   for (size_t i = 0; i < parts.size(); ++i) {
+      if (parts[i].nbytes >= 0) continue;
+      std::cerr << "PickEvents2: cannot read entries " << ranges[i].first << "-" << ranges[i].last << " of "
+                << ranges[i].file << ", reading the list serially" << std::endl;
+      return LoadColumns(runs, events, lumis);
+   }
+
+   // merged in file and entry order, as LoadColumns would return them
+   size_t n = 0;
+   for (const Columns &part : parts) n += part.runs.size();
+   runs.reserve(n);
+   events.reserve(n);
+   lumis.reserve(n);
+   Long64_t nbytes = 0;
+   for (Columns &part : parts) {
+      runs.insert(runs.end(), part.runs.begin(), part.runs.end());
+      events.insert(events.end(), part.events.begin(), part.events.end());
+      lumis.insert(lumis.end(), part.lumis.begin(), part.lumis.end());
+      nbytes += part.nbytes;
+      part = Columns();
+   }
+   return nbytes;
+}
 
+Long64_t PickEvents2::LoadStream(PickEventsIndex::Stream &stream)
+{
+   if (nLoadThreads > 1) {
+      // as LoadColumnsMT, one stream per range merged at the end, and the
+      // serial read below if any range fails
+      ROOT::EnableThreadSafety();
+      const std::string treeName = fChain->GetName();
+      std::vector<ClusterRange> ranges;
+      if (clusterRanges(fChain, nLoadThreads, ranges)) {
+         std::vector<PickEventsIndex::Stream> parts(ranges.size(), PickEventsIndex::Stream(stream.options()));
+         std::vector<Long64_t> nbytes(ranges.size(), 0);
+         std::vector<size_t> tasks(ranges.size());
+         for (size_t i = 0; i < tasks.size(); ++i) tasks[i] = i;
+         ROOT::TThreadExecutor(nLoadThreads).Foreach([&](size_t i) {
+            PickEventsIndex::Stream &part = parts[i];
+            nbytes[i] = readRange(treeName, ranges[i], [&part](Long64_t r, Long64_t e, Long64_t l) { part.add(r, e, l); });
+         }, tasks);
+         size_t failed = 0;
+         while (failed < ranges.size() && nbytes[failed] >= 0) ++failed;
+         if (failed == ranges.size()) {
+            Long64_t total = 0;
+            for (size_t i = 0; i < parts.size(); ++i) {
+               stream.merge(parts[i]);
+               total += nbytes[i];
+            }
+            return total;
+         }
+         std::cerr << "PickEvents2: cannot read entries " << ranges[failed].first << "-" << ranges[failed].last
+                   << " of " << ranges[failed].file << std::endl;
+      }
+      std::cerr << "PickEvents2: reading the list serially" << std::endl;
+   }
 
-   //}
-   //cout << list_runs << endl;
-   //put the preprocess in loop
-   //run_to_event_map.clear();
-   //assert(list_runs.size() == list_events.size() );
-   //for (Int_t i=0; i < (Int_t) list_runs.size(); i++) {
-     //Long64_t run_i = list_runs[i];
-      //Long64_t event_i = list_events[i];
-      //if (run_to_event_map.find(run_i) == run_to_event_map.end() ) {
-	//run_to_event_map[run_i] = std::vector<Long64_t>();
-	 //}
-      //run_to_event_map[run_i].push_back(event_i);
-      //}
-   for (auto &it : run_to_event_map) {
-     sort(it.second.begin(), it.second.end());
+   readIdColumnsOnly(fChain);
+   Long64_t nentries = fChain->GetEntriesFast();
+   Long64_t nbytes = 0;
+   for (Long64_t jentry=0; jentry < nentries; jentry++) {
+      Long64_t ientry = LoadTree(jentry);
+      if (ientry < 0) break;
+      nbytes += b_run->GetEntry(ientry);
+      nbytes += b_event->GetEntry(ientry);
+      if (b_lumi) nbytes += b_lumi->GetEntry(ientry);
+      else lumi = -1;
+      stream.add(run, event, lumi);
    }
+   return nbytes;
+}
+
+bool PickEvents2::LoadBinary(const char *path, bool verify)
+{
+   const PickEventsIndex::Options options = indexOptions();
+   reloader.reset();
+   lazy.reset();
+   cursor.reset();
+   index = PickEventsIndex::shared(std::string("binary:") + path + "|" + options.key(), [&]() {
+      auto start = std::chrono::steady_clock::now();
+      std::string error;
+      auto built = PickEventsIndex::fromBinary(path, verify, options, error);
+      if (!built) {
+         std::cerr << "PickEvents2: " << error << std::endl;
+         return PickEventsIndex::Ptr();
+      }
+      built->loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      return PickEventsIndex::Ptr(built);
+   });
+   return bool(index);
+}
+
+bool PickEvents2::WriteBinary(const char *path, ULong64_t sourceChecksum)
+{
+   if (!index) PickEvents2::Loop();
+   if (!index || !index->list()) return false;
+   EventListWriter writer(path);
+   if (!writer.good()) return false;
+   writer.addList(*index->list());
+   const LumiIndex &lumis = index->lumis();
+   for (size_t i = 0; i < lumis.size(); ++i) writer.addLumi(lumis.key(i), lumis.count(i));
+   return writer.close(sourceChecksum);
 }
 
 // bool PickEvents2::bsearch(std::vector<Long64_t> &v, Long64_t value) {
@@ -105,21 +428,170 @@ void PickEvents2::Loop()
 
 
 bool PickEvents2::match(Long64_t sample_run, Long64_t sample_event) {
-  PickEvents2::Loop();
    //PickEvents2::bsearch(std::vector<Long64_t> &v, Int_t value);
-   if (run_to_event_map.find(sample_run) == run_to_event_map.end() ) {
-      return false;
-   }
    //return PickEvents2::bsearch(run_to_event_map[sample_run], sample_event);
-   auto N = run_to_event_map[sample_run].size();
-   std::vector<Long64_t> vec = run_to_event_map[sample_run];
-   // sort (vec.begin(), vec.end());
-   //Long64_t arr[N] = &vec[0];
-   auto J = TMath::BinarySearch(N , vec.data(), sample_event);
-   bool found = vec[J] == sample_event;
-   if ( found ) return true;
-   return false;
+   refresh();
+   // a clock read costs about as much as a lookup: time one in kTimingStride
+   const bool timed = (nLookups++ & (kTimingStride - 1)) == 0;
+   std::chrono::steady_clock::time_point start;
+   if (timed) start = std::chrono::steady_clock::now();
+   const bool found = lookup(sample_run, sample_event);
+   if (timed) matchSeconds += kTimingStride * std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   if (found) nHits++;
+   if (sample_run != lastRun) {
+      lastRun = sample_run;
+      if ((index && !index->hasRun(sample_run)) || (lazy && !lazy->hasRun(sample_run))) runsNotInList.insert(sample_run);
+   }
+   return found;
+}
+
+bool PickEvents2::lookup(Long64_t sample_run, Long64_t sample_event) {
+   if (lazy) {
+      // the run's events are read on its first lookup, by whichever handle gets there first
+      if (!cursor.pinned(sample_run)) {
+         const std::vector<Long64_t> *events = lazy->events(sample_run);
+         if (events) cursor.pin(sample_run, events->data(), events->size());
+         else cursor.pin(sample_run, 0, 0);
+         nRunSwitches++;
+      }
+      return cursor.contains(sample_event);
+   }
+   if (!index) return false;
+   const EventListView *list = index->list();
+   if (runScoped && list) {
+      if (!cursor.pinned(sample_run)) {
+         size_t i = list->findRun(sample_run);
+         if (i == list->nRuns()) cursor.pin(sample_run, 0, 0);
+         else cursor.pin(sample_run, list->events(i), list->nEvents(i));
+         nRunSwitches++;
+      }
+      return cursor.contains(sample_event);
+   }
+   if (const EventBloomFilter *filter = index->filter()) {
+      if (!filter->mayContain(sample_run, sample_event)) {
+         nPrefilterRejected++;
+         return false;
+      }
+      bool found = index->index().contains(sample_run, sample_event);
+      if (!found) nPrefilterFalsePositives++;
+      return found;
+   }
+   return index->index().contains(sample_run, sample_event);
+}
+
+void PickEvents2::matchBatch(const Long64_t *runs, const Long64_t *events, size_t n, std::vector<ULong64_t> &mask) {
+   refresh();
+   if (lazy) {
+      auto start = std::chrono::steady_clock::now();
+      mask.assign((n + 63) / 64, 0);
+      for (size_t i = 0; i < n; ++i)
+         if (lookup(runs[i], events[i])) mask[i >> 6] |= 1ULL << (i & 63);
+      batchSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      nBatchLookups += n;
+      return;
+   }
+   if (!index) {
+      mask.assign((n + 63) / 64, 0);
+      return;
+   }
+   auto start = std::chrono::steady_clock::now();
+   index->matchBatch(runs, events, n, mask);
+   batchSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   nBatchLookups += n;
+}
+
+void PickEvents2::printStats(std::ostream &os) const {
+   os << "PickEvents2 selection:" << std::endl
+      << "  lookups: " << nLookups << ", hits: " << nHits << ", misses: " << nLookups - nHits
+      << " (hit rate " << (nLookups ? double(nHits) / nLookups : 0.) << ")" << std::endl
+      << "  time in match: " << matchSeconds << " s (" << (nLookups ? matchSeconds * 1e9 / nLookups : 0.)
+      << " ns/lookup, sampled)" << std::endl
+      << "  runs seen that are not in the list: " << runsNotInList.size();
+   size_t shown = 0;
+   for (Long64_t r : runsNotInList) {
+      if (shown++ == 10) {
+         os << " ...";
+         break;
+      }
+      os << (shown == 1 ? " (" : " ") << r;
+   }
+   os << (shown ? ")" : "") << std::endl;
+   if (lazy) {
+      os << "PickEvents2 lazy list:" << std::endl
+         << "  runs in list: " << lazy->nRuns() << ", read: " << lazy->nRunsLoaded() << std::endl
+         << "  entries read: " << lazy->entriesRead() << " of " << lazy->entries() << ", " << lazy->bytesRead()
+         << " bytes" << std::endl
+         << "  run index: " << lazy->indexSeconds() << " s" << (lazy->indexFromCache() ? " (cached)" : " (built)")
+         << std::endl;
+      if (runScoped || nRunSwitches) os << "  run switches: " << nRunSwitches << std::endl;
+      return;
+   }
+   os << "PickEvents2 index:" << std::endl;
+   if (!index) {
+      os << "  not built" << std::endl;
+      return;
+   }
+   index->index().printStats(os);
+   if (index->peakBytes)
+      os << "  build peak bytes: " << index->peakBytes << " ("
+         << (index->index().size() ? double(index->peakBytes) / index->index().size() : 0.) << " per event)" << std::endl;
+   os << "  load time: " << index->loadSeconds << " s, " << index->loadBytes << " bytes read" << std::endl;
+   os << "  shared by " << index.use_count() << " handles" << std::endl;
+   os << "  lumi sections with picked events: " << index->lumis().size() << std::endl;
+   if (runScoped) os << "  run-scoped lookups, run switches: " << nRunSwitches << std::endl;
+   if (reloader)
+      os << "  reloads picked up: " << nReloads << " (list rebuilt " << reloader->nRebuilds() << " times, appended to "
+         << reloader->nAppends() << " times)" << std::endl;
+   if (nBatchLookups)
+      os << "  batch lookups: " << nBatchLookups << " in " << batchSeconds << " s ("
+         << (batchSeconds > 0 ? nBatchLookups / batchSeconds : 0.) << " lookups/s)" << std::endl;
+   if (const EventBloomFilter *filter = index->filter()) {
+      ULong64_t nneg = nPrefilterRejected + nPrefilterFalsePositives;
+      os << "PickEvents2 prefilter:" << std::endl
+         << "  bits per key: " << filter->bitsPerKey() << std::endl
+         << "  hashes: " << filter->nHashes() << std::endl
+         << "  bytes: " << filter->bytes() << std::endl
+         << "  configured FPR: " << filter->targetFPR() << std::endl
+         << "  observed FPR: " << (nneg ? double(nPrefilterFalsePositives) / nneg : 0.)
+         << " (" << nPrefilterFalsePositives << "/" << nneg << " negatives)" << std::endl;
+   }
+}
+void PickEvents2::writeStatsJson(std::ostream &os) const {
+   os << "{\"lookups\": " << nLookups << ", \"hits\": " << nHits << ", \"misses\": " << nLookups - nHits
+      << ", \"match_seconds\": " << matchSeconds << ", \"runs_not_in_list\": [";
+   size_t i = 0;
+   for (Long64_t r : runsNotInList) os << (i++ ? ", " : "") << r;
+   os << "], \"batch_lookups\": " << nBatchLookups << ", \"batch_seconds\": " << batchSeconds
+      << ", \"prefilter_rejected\": " << nPrefilterRejected
+      << ", \"prefilter_false_positives\": " << nPrefilterFalsePositives << ", \"run_switches\": " << nRunSwitches
+      << ", \"reloads\": " << nReloads;
+   if (lazy)
+      os << ", \"lazy_runs\": " << lazy->nRuns() << ", \"lazy_runs_read\": " << lazy->nRunsLoaded()
+         << ", \"lazy_entries_read\": " << lazy->entriesRead() << ", \"lazy_bytes_read\": " << lazy->bytesRead()
+         << ", \"lazy_index_seconds\": " << lazy->indexSeconds();
+   if (index)
+      os << ", \"backend\": \"" << index->index().name() << "\", \"list_events\": " << index->index().size()
+         << ", \"list_runs\": " << index->nRuns() << ", \"index_bytes\": " << index->index().bytes()
+         << ", \"build_peak_bytes\": " << index->peakBytes
+         << ", \"load_seconds\": " << index->loadSeconds << ", \"load_bytes\": " << index->loadBytes;
+   os << "}" << std::endl;
+}
+
+bool PickEvents2::lumiHasEvents(Long64_t sample_run, Long64_t sample_lumi) {
+   refresh();
+   return index && index->lumis().hasEvents(sample_run, sample_lumi);
+}
+
+ULong64_t PickEvents2::lumiEventCount(Long64_t sample_run, Long64_t sample_lumi) {
+   refresh();
+   return index ? index->lumis().eventCount(sample_run, sample_lumi) : 0;
 }
+
+void PickEvents2::writeLumiRanges(std::ostream &os, bool json) {
+   if (!index) PickEvents2::Loop();
+   if (index) index->lumis().writeRanges(os, json);
+}
+
 //test on match(297292, 840021146)   //true  match(297292, 839822512)
 //match(297292, 840044967) 
 
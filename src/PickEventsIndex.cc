@@ -0,0 +1,377 @@
+#include "JetMETStudies/JMEAnalyzer/interface/PickEventsIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/FlatEventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/HashEventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/CompressedEventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/MappedEventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/OverlayEventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EmbeddedEventIndex.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+#include <ROOT/TThreadExecutor.hxx>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <mutex>
+
+const double PickEventsIndex::kMaxAppendedFraction = 0.25;
+
+std::string PickEventsIndex::Options::key() const
+{
+   // nThreads only changes how fast the index is built, not what it holds.
+   // %a is exact: two rates share a key only if they are the same double
+   char fpr[32];
+   std::snprintf(fpr, sizeof(fpr), "%a", prefilterFPR);
+   return std::to_string(int(backend)) + "/" + fpr;
+}
+
+bool PickEventsIndex::backendFromName(const std::string &name, Backend &backend)
+{
+   if (name == "sorted") backend = kSorted;
+   else if (name == "hash") backend = kHash;
+   else if (name == "compressed") backend = kCompressed;
+   else return false;
+   return true;
+}
+
+void PickEventsIndex::build(const Options &options)
+{
+   const EventListView &list = *fList;
+   const MappedEventList *mapped = dynamic_cast<const MappedEventList*>(&list);
+   fRuns.resize(list.nRuns());
+   for (size_t i = 0; i < fRuns.size(); ++i) fRuns[i] = list.run(i);
+   if (options.backend == kHash) fIndex.reset(new HashEventIndex(list));
+   else if (options.backend == kCompressed) fIndex.reset(new CompressedEventIndex(list));
+   // the mapped file already holds sorted per-run blocks, search it in place
+   else if (mapped) fIndex.reset(new MappedEventIndex(*mapped));
+   else fIndex.reset(new FlatEventIndex(list));
+   if (options.prefilterFPR > 0) fFilter.reset(new EventBloomFilter(list, options.prefilterFPR));
+}
+
+std::shared_ptr<PickEventsIndex> PickEventsIndex::fromColumns(const std::vector<Long64_t> &runs,
+                                                              const std::vector<Long64_t> &events,
+                                                              const std::vector<Long64_t> &lumis,
+                                                              const Options &options)
+{
+   if (options.backend == kCompressed) {
+      // straight into compressed blocks: no per-run arrays, no lumi key per event
+      Stream stream(options);
+      for (size_t i = 0; i < runs.size(); i++) stream.add(runs[i], events[i], lumis[i]);
+      return stream.finish();
+   }
+
+   std::shared_ptr<PickEventsIndex> result(new PickEventsIndex());
+   std::map<Long64_t, std::vector<Long64_t>> &run_to_event_map = result->fRunToEvents;
+   std::vector<ULong64_t> lumi_keys;
+   lumi_keys.reserve(runs.size());
+   //lists are grouped by run, so the map is only searched when the run changes
+   std::vector<Long64_t> *current = 0;
+   Long64_t current_run = -1;
+   for (size_t i = 0; i < runs.size(); i++) {
+      if (!current || runs[i] != current_run) {
+         current_run = runs[i];
+         current = &run_to_event_map[current_run];
+      }
+      current->push_back(events[i]);
+      if (lumis[i] >= 0) lumi_keys.push_back(LumiIndex::pack(runs[i], lumis[i]));
+   }
+
+   std::vector<std::vector<Long64_t>*> per_run;
+   for (auto &it : run_to_event_map) per_run.push_back(&it.second);
+   auto sort_run = [](std::vector<Long64_t> *v) {
+      std::sort(v->begin(), v->end());
+      v->erase(std::unique(v->begin(), v->end()), v->end());
+   };
+   if (options.nThreads > 1) ROOT::TThreadExecutor(options.nThreads).Foreach(sort_run, per_run);
+   else for (auto v : per_run) sort_run(v);
+
+   result->fList.reset(new MapEventListView(run_to_event_map));
+   result->build(options);
+   // the arrays stay, the lumi keys go once counted
+   result->peakBytes = result->fList->totalEvents() * sizeof(Long64_t) + lumi_keys.capacity() * sizeof(ULong64_t) +
+                       result->fIndex->bytes() + (result->fFilter ? result->fFilter->bytes() : 0);
+   result->fLumis = LumiIndex(std::move(lumi_keys));
+   return result;
+}
+
+void PickEventsIndex::Stream::merge(Stream &other)
+{
+   fEvents.merge(other.fEvents);
+   for (auto &it : other.fLumiCounts) fLumiCounts[it.first] += it.second;
+   other.fLumiCounts.clear();
+   other.fLastCount = fLastCount = 0;
+}
+
+std::shared_ptr<PickEventsIndex> PickEventsIndex::Stream::finish()
+{
+   std::shared_ptr<PickEventsIndex> result(new PickEventsIndex());
+   std::unique_ptr<EventBloomFilter> filter;
+   // sized for the pairs read, duplicates included
+   if (fOptions.prefilterFPR > 0) filter.reset(new EventBloomFilter(fEvents.size(), fOptions.prefilterFPR));
+   std::vector<Long64_t> &runs = result->fRuns;
+   std::unique_ptr<CompressedEventIndex> index =
+      fEvents.finish([&runs, &filter](Long64_t run, const Long64_t *events, size_t n) {
+         runs.push_back(run);
+         if (filter) filter->add(run, events, n);
+      });
+   result->fIndex = std::move(index);
+   result->fFilter = std::move(filter);
+
+   std::vector<EventListLumiEntry> table;
+   table.reserve(fLumiCounts.size());
+   for (auto &it : fLumiCounts) table.push_back(EventListLumiEntry{it.first, it.second});
+   // a map node holds the pair and about four pointers
+   const size_t lumiBytes = fLumiCounts.size() * (2 * sizeof(ULong64_t) + 4 * sizeof(void*));
+   fLumiCounts.clear();
+   fLastCount = 0;
+   result->fLumis = LumiIndex(table.data(), table.size());
+   result->peakBytes = fEvents.peakBytes() + lumiBytes + (result->fFilter ? result->fFilter->bytes() : 0);
+   return result;
+}
+
+std::shared_ptr<PickEventsIndex> PickEventsIndex::fromEmbedded(const EmbeddedEventList &list)
+{
+   std::shared_ptr<PickEventsIndex> result(new PickEventsIndex());
+   for (ULong64_t i = 0; i < list.nSlots(); i++)
+      if (list.at(i).run >= 0) result->fRuns.push_back(list.at(i).run);
+   std::sort(result->fRuns.begin(), result->fRuns.end());
+   result->fRuns.erase(std::unique(result->fRuns.begin(), result->fRuns.end()), result->fRuns.end());
+   result->fIndex.reset(new EmbeddedEventIndex(list));
+   return result;
+}
+
+std::shared_ptr<PickEventsIndex> PickEventsIndex::appended(const Ptr &base,
+                                                            const std::vector<Long64_t> &runs,
+                                                            const std::vector<Long64_t> &events,
+                                                            const std::vector<Long64_t> &lumis,
+                                                            const Options &options)
+{
+   const EventListView *list = base ? base->list() : 0;
+   if (!list || options.backend == kCompressed) return std::shared_ptr<PickEventsIndex>();
+
+   // everything added on top of the original base, the earlier appends
+   // included: the overlay is always one level deep
+   const Ptr root = base->fBase ? base->fBase : base;
+   std::map<Long64_t, std::vector<Long64_t>> added = base->fAdded;
+   std::vector<ULong64_t> lumi_keys;
+   std::vector<std::vector<Long64_t>*> touched;
+   for (size_t i = 0; i < runs.size(); i++) {
+      if (lumis[i] >= 0) lumi_keys.push_back(LumiIndex::pack(runs[i], lumis[i]));
+      if (root->fIndex->contains(runs[i], events[i])) continue;
+      std::vector<Long64_t> &more = added[runs[i]];
+      if (!more.empty() && more.back() >= events[i]) touched.push_back(&more);
+      more.push_back(events[i]);
+   }
+   std::sort(touched.begin(), touched.end());
+   touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+   for (std::vector<Long64_t> *v : touched) {
+      std::sort(v->begin(), v->end());
+      v->erase(std::unique(v->begin(), v->end()), v->end());
+   }
+   size_t nadded = 0;
+   for (auto &it : added) nadded += it.second.size();
+
+   std::shared_ptr<PickEventsIndex> result(new PickEventsIndex());
+   std::map<Long64_t, std::vector<Long64_t>> &run_to_event_map = result->fRunToEvents;
+   if (nadded > kMaxAppendedFraction * root->fIndex->size()) {
+      // the overlay got large: one full build, after which appends share it
+      for (size_t i = 0; i < list->nRuns(); i++)
+         run_to_event_map[list->run(i)].assign(list->events(i), list->events(i) + list->nEvents(i));
+      for (auto &it : added) {
+         std::vector<Long64_t> &v = run_to_event_map[it.first];
+         std::vector<Long64_t> merged;
+         merged.reserve(v.size() + it.second.size());
+         std::merge(v.begin(), v.end(), it.second.begin(), it.second.end(), std::back_inserter(merged));
+         merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+         v.swap(merged);
+      }
+      result->fList.reset(new MapEventListView(run_to_event_map));
+      result->build(options);
+   } else {
+      // only the runs that received events get new arrays (root's events of
+      // the run merged with the added ones); all others are root's own
+      const EventListView &rootList = *root->fList;
+      for (auto &it : added) {
+         std::vector<Long64_t> &v = run_to_event_map[it.first];
+         const size_t ir = rootList.findRun(it.first);
+         const Long64_t *had = ir < rootList.nRuns() ? rootList.events(ir) : 0;
+         const size_t nhad = ir < rootList.nRuns() ? rootList.nEvents(ir) : 0;
+         v.reserve(nhad + it.second.size());
+         std::merge(had, had + nhad, it.second.begin(), it.second.end(), std::back_inserter(v));
+      }
+      result->fBase = root;
+      result->fAdded.swap(added);
+      result->fList.reset(new OverlayEventListView(rootList, run_to_event_map));
+      const EventListView &list = *result->fList;
+      result->fRuns.resize(list.nRuns());
+      for (size_t i = 0; i < result->fRuns.size(); ++i) result->fRuns[i] = list.run(i);
+
+      MapEventListView more(result->fAdded);
+      std::unique_ptr<EventIndex> index;
+      if (options.backend == kHash) index.reset(new HashEventIndex(more));
+      else index.reset(new FlatEventIndex(more));
+      result->fIndex.reset(new OverlayEventIndex(*root->fIndex, std::move(index)));
+      if (root->fFilter) {
+         result->fFilter.reset(new EventBloomFilter(*root->fFilter));
+         result->fFilter->add(more);
+      } else if (options.prefilterFPR > 0) {
+         result->fFilter.reset(new EventBloomFilter(list, options.prefilterFPR));
+      }
+   }
+   result->fLumis = LumiIndex(base->lumis(), std::move(lumi_keys));
+   return result;
+}
+
+size_t PickEventsIndex::nAppended() const
+{
+   size_t n = 0;
+   for (auto &it : fAdded) n += it.second.size();
+   return n;
+}
+
+std::shared_ptr<PickEventsIndex> PickEventsIndex::fromBinary(const std::string &path, bool verify,
+                                                             const Options &options, std::string &error)
+{
+   std::unique_ptr<MappedEventList> mapped(new MappedEventList());
+   if (!mapped->open(path, verify)) {
+      error = mapped->error();
+      return std::shared_ptr<PickEventsIndex>();
+   }
+   std::shared_ptr<PickEventsIndex> result(new PickEventsIndex());
+   result->fLumis = LumiIndex(mapped->lumis(), mapped->nLumis());
+   result->loadBytes = mapped->mappedBytes();
+   result->fList = std::move(mapped);
+   result->build(options);
+   return result;
+}
+
+PickEventsIndex::Ptr PickEventsIndex::shared(const std::string &key, const std::function<Ptr()> &build)
+{
+   // held across the build: a second caller for the same list waits for
+   // the first one instead of building its own copy. Only taken at setup.
+   static std::mutex cache_mutex;
+   static std::map<std::string, std::weak_ptr<const PickEventsIndex>> cache;
+
+   std::lock_guard<std::mutex> lock(cache_mutex);
+   auto it = cache.find(key);
+   if (it != cache.end()) {
+      if (Ptr live = it->second.lock()) return live;
+   }
+   Ptr built = build();
+   if (built) cache[key] = built;
+   return built;
+}
+
+// first position in [events+j, events+n) not below value. Blocks of eight
+// are compared branch-free so the compiler can use vector compares; long
+// runs of smaller events (sparse queries on a dense list) are galloped over.
+static size_t advanceTo(const Long64_t *events, size_t j, size_t n, Long64_t value)
+{
+   while (j + 8 <= n) {
+      size_t below = 0;
+      for (size_t t = 0; t < 8; ++t) below += events[j + t] < value;
+      if (below < 8) return j + below;
+      j += 8;
+      if (j < n && events[j] < value) {
+         size_t step = 8;
+         while (j + step < n && events[j + step] < value) {
+            j += step;
+            step <<= 1;
+         }
+         size_t hi = j + step < n ? j + step : n;
+         return std::lower_bound(events + j, events + hi, value) - events;
+      }
+   }
+   while (j < n && events[j] < value) ++j;
+   return j;
+}
+
+void PickEventsIndex::matchBatch(const Long64_t *runs, const Long64_t *events, size_t n,
+                                 std::vector<ULong64_t> &mask) const
+{
+   mask.assign((n + 63) / 64, 0);
+   if (n == 0) return;
+   bool sorted = true;
+   for (size_t i = 1; i < n && sorted; ++i)
+      sorted = runs[i - 1] < runs[i] || (runs[i - 1] == runs[i] && events[i - 1] <= events[i]);
+
+   const EventListView *view = list();
+   // the compressed backend keeps no plain arrays to join against, and for
+   // unordered queries hash probes are cheaper than sorting them
+   if (!view || (!sorted && fIndex->randomAccess())) {
+      for (size_t i = 0; i < n; ++i)
+         if (contains(runs[i], events[i])) mask[i >> 6] |= 1ULL << (i & 63);
+      return;
+   }
+
+   if (sorted) {
+      for (size_t q = 0, qend; q < n; q = qend) {
+         for (qend = q + 1; qend < n && runs[qend] == runs[q]; ++qend) {}
+         const size_t ir = view->findRun(runs[q]);
+         if (ir == view->nRuns()) continue;
+         const Long64_t *list_events = view->events(ir);
+         const size_t m = view->nEvents(ir);
+         size_t j = 0;
+         for (size_t i = q; i < qend && j < m; ++i) {
+            j = advanceTo(list_events, j, m, events[i]);
+            if (j < m && list_events[j] == events[i]) mask[i >> 6] |= 1ULL << (i & 63);
+         }
+      }
+      return;
+   }
+
+   // Queries on runs that are not in the list are answered (no) right away.
+   // The others are sorted by (position of the run, event) without any
+   // comparison sort: an LSD radix sort on the event, then a stable counting
+   // sort on the run. Ntuples are ordered by run, so the run of the previous
+   // query is tried before searching.
+   struct Query {
+      ULong64_t key; // event - smallest event
+      UInt_t    idx;
+   };
+   const size_t nruns = view->nRuns();
+   std::vector<UInt_t> slot(n);
+   std::vector<size_t> start(nruns + 1, 0);
+   Long64_t lo = 0, hi = 0;
+   bool first = true;
+   size_t ir = nruns;
+   for (size_t i = 0; i < n; ++i) {
+      if (i == 0 || runs[i] != runs[i - 1]) ir = view->findRun(runs[i]);
+      slot[i] = ir;
+      if (ir == nruns) continue;
+      ++start[ir + 1];
+      if (first || events[i] < lo) lo = events[i];
+      if (first || events[i] > hi) hi = events[i];
+      first = false;
+   }
+   for (size_t r = 0; r < nruns; ++r) start[r + 1] += start[r];
+   const size_t nq = start[nruns];
+
+   std::vector<Query> queries, buffer(nq);
+   queries.reserve(nq);
+   for (size_t i = 0; i < n; ++i)
+      if (slot[i] != nruns) queries.push_back(Query{ULong64_t(events[i] - lo), UInt_t(i)});
+   const int kBits = 11;
+   const ULong64_t range = ULong64_t(hi - lo);
+   std::vector<size_t> count((1 << kBits) + 1);
+   for (int shift = 0; shift < 64 && (range >> shift) != 0; shift += kBits) {
+      std::fill(count.begin(), count.end(), 0);
+      for (const Query &q : queries) ++count[((q.key >> shift) & ((1 << kBits) - 1)) + 1];
+      for (size_t d = 1; d < count.size(); ++d) count[d] += count[d - 1];
+      for (const Query &q : queries) buffer[count[(q.key >> shift) & ((1 << kBits) - 1)]++] = q;
+      queries.swap(buffer);
+   }
+   std::vector<size_t> fill(start.begin(), start.end() - 1);
+   for (const Query &q : queries) buffer[fill[slot[q.idx]]++] = q;
+   queries.swap(buffer);
+
+   for (size_t r = 0; r < nruns; ++r) {
+      const Query *q = queries.data() + start[r], *qend = queries.data() + start[r + 1];
+      const Long64_t *list_events = view->events(r);
+      const size_t m = view->nEvents(r);
+      size_t j = 0;
+      for (; q != qend && j < m; ++q) {
+         const Long64_t event = Long64_t(q->key) + lo;
+         j = advanceTo(list_events, j, m, event);
+         if (j < m && list_events[j] == event) mask[q->idx >> 6] |= 1ULL << (q->idx & 63);
+      }
+   }
+}
@@ -0,0 +1,244 @@
+#include "JetMETStudies/JMEAnalyzer/interface/PickEventsReloader.h"
+#include "JetMETStudies/JMEAnalyzer/interface/EventListFile.h"
+#include <TROOT.h>
+#include <TChain.h>
+#include <TTreeReader.h>
+#include <TTreeReaderValue.h>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+
+static bool endsWith(const std::string &s, const std::string &suffix)
+{
+   return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+PickEventsReloader::PickEventsReloader(const std::vector<std::string> &files, const PickEventsIndex::Options &options)
+   : fFormat(kText), fOptions(options), fGeneration(0), fRebuilds(0), fAppends(0), fStop(false)
+{
+   if (!files.empty() && endsWith(files[0], ".pevl")) fFormat = kBinary;
+   else if (!files.empty() && endsWith(files[0], ".root")) fFormat = kRoot;
+   for (const std::string &f : files) {
+      fSources.push_back(Source{f, 0, -1, 0, 0, 0});
+      // only the first binary list is used, as by PickEvents2::LoadBinary
+      if (fFormat == kBinary) break;
+   }
+}
+
+PickEventsReloader::~PickEventsReloader()
+{
+   stop();
+}
+
+std::string PickEventsReloader::error() const
+{
+   std::lock_guard<std::mutex> lock(fMutex);
+   return fError;
+}
+
+void PickEventsReloader::setError(const std::string &error)
+{
+   std::cerr << "PickEventsReloader: " << error << std::endl;
+   std::lock_guard<std::mutex> lock(fMutex);
+   fError = error;
+}
+
+bool PickEventsReloader::stat(Source &source) const
+{
+   struct stat st;
+   if (::stat(source.path.c_str(), &st) != 0) return false;
+   source.inode = st.st_ino;
+   source.size = st.st_size;
+   source.mtime = Long64_t(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+   return true;
+}
+
+ULong64_t PickEventsReloader::tailHash(const std::string &path, Long64_t end) const
+{
+   // enough to tell an append from a rewrite that kept or grew the size
+   const Long64_t n = std::min<Long64_t>(end, 4096);
+   std::vector<char> buffer(n);
+   std::ifstream in(path.c_str(), std::ios::binary);
+   in.seekg(end - n);
+   if (!in.read(buffer.data(), n)) return ~0ULL;
+   return eventListChecksum(buffer.data(), n);
+}
+
+bool PickEventsReloader::readText(Source &source, Long64_t from, TextEventList::Columns &columns)
+{
+   std::ifstream in(source.path.c_str(), std::ios::binary);
+   if (!in) {
+      setError("cannot open " + source.path);
+      return false;
+   }
+   in.seekg(from);
+   std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+   // a line still being written is left for the next poll
+   const size_t complete = text.rfind('\n') == std::string::npos ? 0 : text.rfind('\n') + 1;
+   size_t bad = TextEventList::parse(text.data(), text.data() + complete,
+                                     TextEventList::runFromFileName(source.path), columns);
+   if (bad) std::cerr << "PickEventsReloader: skipped " << bad << " malformed lines in " << source.path << std::endl;
+   source.consumed = from + complete;
+   source.tailHash = tailHash(source.path, source.consumed);
+   return true;
+}
+
+PickEventsIndex::Ptr PickEventsReloader::rebuild(std::vector<Source> &sources)
+{
+   auto start = std::chrono::steady_clock::now();
+   std::shared_ptr<PickEventsIndex> built;
+   Long64_t nbytes = 0;
+   if (fFormat == kBinary) {
+      std::string error;
+      built = PickEventsIndex::fromBinary(sources[0].path, false, fOptions, error);
+      if (!built) {
+         setError(error);
+         return PickEventsIndex::Ptr();
+      }
+      nbytes = built->loadBytes;
+   } else if (fFormat == kRoot) {
+      TChain chain("tree");
+      for (const Source &s : sources) chain.Add(s.path.c_str());
+      TTreeReader reader(&chain);
+      TTreeReaderValue<Long64_t> run(reader, "run");
+      TTreeReaderValue<Long64_t> event(reader, "event");
+      TTreeReaderValue<Long64_t> lumi(reader, "lumi");
+      // the compressed backend takes the pairs as they are read
+      const bool stream = fOptions.backend == PickEventsIndex::kCompressed;
+      PickEventsIndex::Stream compressed(fOptions);
+      std::vector<Long64_t> runs, events, lumis;
+      Long64_t nentries = 0;
+      while (reader.Next()) {
+         ++nentries;
+         if (stream) {
+            compressed.add(*run, *event, *lumi);
+            continue;
+         }
+         runs.push_back(*run);
+         events.push_back(*event);
+         lumis.push_back(*lumi);
+      }
+      if (reader.GetEntryStatus() != TTreeReader::kEntryBeyondEnd) {
+         setError("cannot read the ROOT pick list");
+         return PickEventsIndex::Ptr();
+      }
+      built = stream ? compressed.finish() : PickEventsIndex::fromColumns(runs, events, lumis, fOptions);
+      nbytes = nentries * 3 * sizeof(Long64_t);
+   } else {
+      TextEventList::Columns columns;
+      for (Source &s : sources) {
+         if (!readText(s, 0, columns)) return PickEventsIndex::Ptr();
+         nbytes += s.consumed;
+      }
+      built = PickEventsIndex::fromColumns(columns.runs, columns.events, columns.lumis, fOptions);
+   }
+   built->loadBytes = nbytes;
+   built->loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   return built;
+}
+
+void PickEventsReloader::publish(PickEventsIndex::Ptr index)
+{
+   std::atomic_store(&fCurrent, index);
+   fGeneration.fetch_add(1, std::memory_order_release);
+}
+
+bool PickEventsReloader::load()
+{
+   for (Source &s : fSources) {
+      if (!stat(s)) {
+         setError("cannot stat " + s.path);
+         return false;
+      }
+   }
+   PickEventsIndex::Ptr built = rebuild(fSources);
+   if (!built) return false;
+   publish(built);
+   return true;
+}
+
+bool PickEventsReloader::poll()
+{
+   std::vector<Source> now = fSources;
+   bool changed = false;
+   for (size_t i = 0; i < now.size(); ++i) {
+      // a file being replaced may be missing for a moment: try again next time
+      if (!stat(now[i])) return false;
+      changed = changed || now[i].inode != fSources[i].inode || now[i].size != fSources[i].size ||
+                now[i].mtime != fSources[i].mtime;
+   }
+   if (!changed) return false;
+
+   PickEventsIndex::Ptr base = current();
+   // the compressed backend keeps no per-run arrays to append to
+   if (fFormat == kText && base && base->list()) {
+      bool grew = true;
+      for (size_t i = 0; i < now.size() && grew; ++i) {
+         const Source &old = fSources[i];
+         grew = now[i].inode == old.inode && now[i].size >= old.consumed &&
+                (old.consumed == 0 || tailHash(now[i].path, old.consumed) == old.tailHash);
+      }
+      if (grew) {
+         auto start = std::chrono::steady_clock::now();
+         TextEventList::Columns columns;
+         Long64_t nbytes = 0;
+         bool ok = true;
+         for (size_t i = 0; i < now.size() && ok; ++i) {
+            if (now[i].size == fSources[i].consumed) continue;
+            ok = readText(now[i], fSources[i].consumed, columns);
+            nbytes += now[i].consumed - fSources[i].consumed;
+         }
+         if (!ok) return false;
+         if (columns.runs.empty()) {
+            // touched, or only part of a line so far
+            fSources = now;
+            return false;
+         }
+         std::shared_ptr<PickEventsIndex> built =
+            PickEventsIndex::appended(base, columns.runs, columns.events, columns.lumis, fOptions);
+         built->loadBytes = nbytes;
+         built->loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         fSources = now;
+         publish(built);
+         fAppends++;
+         return true;
+      }
+   }
+
+   PickEventsIndex::Ptr built = rebuild(now);
+   if (!built) return false;
+   fSources = now;
+   publish(built);
+   fRebuilds++;
+   return true;
+}
+
+void PickEventsReloader::start(double pollSeconds)
+{
+   if (fThread.joinable()) return;
+   // the watcher reads ROOT files off the main thread
+   if (fFormat == kRoot) ROOT::EnableThreadSafety();
+   fStop = false;
+   const auto period = std::chrono::duration<double>(pollSeconds);
+   fThread = std::thread([this, period]() {
+      std::unique_lock<std::mutex> lock(fMutex);
+      while (!fWake.wait_for(lock, period, [this]() { return fStop; })) {
+         lock.unlock();
+         poll();
+         lock.lock();
+      }
+   });
+}
+
+void PickEventsReloader::stop()
+{
+   if (!fThread.joinable()) return;
+   {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fStop = true;
+   }
+   fWake.notify_all();
+   fThread.join();
+}
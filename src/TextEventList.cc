@@ -0,0 +1,215 @@
+#include "JetMETStudies/JMEAnalyzer/interface/TextEventList.h"
+#include <ROOT/TThreadExecutor.hxx>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static inline bool isSeparator(char c)
+{
+   return c == ' ' || c == '\t' || c == ':' || c == ',' || c == '\r';
+}
+
+size_t TextEventList::parse(const char *begin, const char *end, Long64_t defaultRun, Columns &out)
+{
+   size_t bad = 0;
+   const char *p = begin;
+   while (p < end) {
+      const char *eol = (const char *)std::memchr(p, '\n', end - p);
+      if (!eol) eol = end;
+      while (p < eol && isSeparator(*p)) ++p;
+      if (p == eol || *p == '#') {
+         p = eol + 1;
+         continue;
+      }
+      Long64_t v[3];
+      int n = 0;
+      bool ok = true;
+      while (p < eol) {
+         if (n == 3) {
+            ok = false;
+            break;
+         }
+         auto res = std::from_chars(p, eol, v[n]);
+         if (res.ec != std::errc()) {
+            ok = false;
+            break;
+         }
+         ++n;
+         p = res.ptr;
+         if (p < eol && !isSeparator(*p)) {
+            ok = false;
+            break;
+         }
+         while (p < eol && isSeparator(*p)) ++p;
+      }
+      if (ok && n == 1 && defaultRun >= 0) {
+         out.runs.push_back(defaultRun);
+         out.events.push_back(v[0]);
+         out.lumis.push_back(-1);
+      } else if (ok && n == 2) {
+         out.runs.push_back(v[0]);
+         out.events.push_back(v[1]);
+         out.lumis.push_back(-1);
+      } else if (ok && n == 3) {
+         out.runs.push_back(v[0]);
+         out.events.push_back(v[2]);
+         out.lumis.push_back(v[1]);
+      } else {
+         ++bad;
+      }
+      p = eol + 1;
+   }
+   return bad;
+}
+
+Long64_t TextEventList::runFromFileName(const std::string &path)
+{
+   size_t slash = path.rfind('/');
+   const std::string base = slash == std::string::npos ? path : path.substr(slash + 1);
+   size_t last = base.find_last_of("0123456789");
+   if (last == std::string::npos) return -1;
+   size_t first = last;
+   while (first > 0 && base[first - 1] >= '0' && base[first - 1] <= '9') --first;
+   Long64_t run = -1;
+   std::from_chars(base.data() + first, base.data() + last + 1, run);
+   return run;
+}
+
+namespace {
+   struct MappedText {
+      const char *data;
+      size_t      size;
+   };
+
+   // maps path read-only; an empty file gives size 0 and no mapping
+   bool mapText(const std::string &path, MappedText &text, std::string &error)
+   {
+      text.data = 0;
+      text.size = 0;
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+         error = "cannot open " + path;
+         return false;
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0) {
+         ::close(fd);
+         error = "cannot stat " + path;
+         return false;
+      }
+      if (st.st_size == 0) {
+         ::close(fd);
+         return true;
+      }
+      void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (map == MAP_FAILED) {
+         error = "cannot mmap " + path;
+         return false;
+      }
+      madvise(map, st.st_size, MADV_SEQUENTIAL);
+      text.data = (const char *)map;
+      text.size = st.st_size;
+      return true;
+   }
+
+   // end of the chunk starting at p: kChunkSize bytes, extended to the end of the line
+   const char *chunkEnd(const char *p, const char *end)
+   {
+      if (end - p <= (ptrdiff_t)TextEventList::kChunkSize) return end;
+      const char *cut = p + TextEventList::kChunkSize;
+      const char *eol = (const char *)std::memchr(cut, '\n', end - cut);
+      return eol ? eol + 1 : end;
+   }
+
+   struct Chunk {
+      const char            *begin;
+      const char            *end;
+      Long64_t               run;
+      TextEventList::Columns columns;
+      size_t                 bad;
+   };
+}
+
+bool TextEventList::load(const std::vector<std::string> &files, UInt_t nThreads)
+{
+   fColumns = Columns();
+   fBadLines = 0;
+   fBytes = 0;
+   fError.clear();
+
+   std::vector<MappedText> maps;
+   auto unmap = [&maps]() {
+      for (auto &m : maps) munmap((void *)m.data, m.size);
+   };
+   std::vector<Chunk> chunks;
+   for (const std::string &path : files) {
+      MappedText text;
+      if (!mapText(path, text, fError)) {
+         unmap();
+         return false;
+      }
+      if (text.size == 0) continue;
+      maps.push_back(text);
+      fBytes += text.size;
+
+      // cut after a newline so that no line straddles two chunks
+      const Long64_t run = runFromFileName(path);
+      for (const char *p = text.data, *end = p + text.size, *cut; p < end; p = cut) {
+         cut = chunkEnd(p, end);
+         chunks.push_back(Chunk{p, cut, run, Columns(), 0});
+      }
+   }
+
+   auto parseChunk = [](Chunk &c) {
+      // a guess of ~20 bytes per line saves most of the reallocations
+      const size_t guess = (c.end - c.begin) / 20;
+      c.columns.runs.reserve(guess);
+      c.columns.events.reserve(guess);
+      c.columns.lumis.reserve(guess);
+      c.bad = parse(c.begin, c.end, c.run, c.columns);
+   };
+   if (nThreads > 1 && chunks.size() > 1) ROOT::TThreadExecutor(nThreads).Foreach(parseChunk, chunks);
+   else for (auto &c : chunks) parseChunk(c);
+   unmap();
+
+   size_t n = 0;
+   for (auto &c : chunks) n += c.columns.runs.size();
+   fColumns.runs.reserve(n);
+   fColumns.events.reserve(n);
+   fColumns.lumis.reserve(n);
+   for (auto &c : chunks) {
+      fColumns.runs.insert(fColumns.runs.end(), c.columns.runs.begin(), c.columns.runs.end());
+      fColumns.events.insert(fColumns.events.end(), c.columns.events.begin(), c.columns.events.end());
+      fColumns.lumis.insert(fColumns.lumis.end(), c.columns.lumis.begin(), c.columns.lumis.end());
+      fBadLines += c.bad;
+      c.columns = Columns();
+   }
+   return true;
+}
+
+bool TextEventList::stream(const std::string &path, const std::function<void(const Columns &)> &consume)
+{
+   fColumns = Columns();
+   fBadLines = 0;
+   fBytes = 0;
+   fError.clear();
+   MappedText text;
+   if (!mapText(path, text, fError)) return false;
+   fBytes = text.size;
+   const Long64_t run = runFromFileName(path);
+   Columns columns;
+   for (const char *p = text.data, *end = p + text.size, *cut; p < end; p = cut) {
+      cut = chunkEnd(p, end);
+      columns.runs.clear();
+      columns.events.clear();
+      columns.lumis.clear();
+      fBadLines += parse(p, cut, run, columns);
+      consume(columns);
+   }
+   if (text.size) munmap((void *)text.data, text.size);
+   return true;
+}
@@ -0,0 +1,54 @@
+#include "JetMETStudies/JMEAnalyzer/interface/TriggerPathTable.h"
+#include <cctype>
+#include <unordered_map>
+
+TriggerPathTable::TriggerPathTable(const std::vector<std::string> &paths) : fLastId(0), fLast(0)
+{
+   for (const std::string &p : paths) fPaths.push_back(baseName(p));
+}
+
+std::string TriggerPathTable::baseName(const std::string &path)
+{
+   std::string base = path;
+   if (base.size() >= 1 && base.back() == '*') base.pop_back();
+   if (base.size() >= 2 && base.compare(base.size() - 2, 2, "_v") == 0) base.resize(base.size() - 2);
+   return base;
+}
+
+bool TriggerPathTable::matches(const std::string &menuName, const std::string &path)
+{
+   if (menuName.compare(0, path.size(), path) != 0) return false;
+   if (menuName.size() == path.size()) return true;
+   if (menuName.size() < path.size() + 3 || menuName.compare(path.size(), 2, "_v") != 0) return false;
+   for (size_t i = path.size() + 2; i < menuName.size(); ++i)
+      if (!std::isdigit((unsigned char)menuName[i])) return false;
+   return true;
+}
+
+const std::vector<int> &TriggerPathTable::resolve(const std::string &menuId, const std::vector<std::string> &menuNames)
+{
+   // the menu changes at run boundaries at most
+   if (fLast && *fLastId == menuId) return *fLast;
+   auto it = fTables.find(menuId);
+   if (it == fTables.end()) {
+      // menu names by base name: one pass over the menu, one hash lookup per path
+      std::unordered_map<std::string, int> byBase;
+      for (size_t i = 0; i < menuNames.size(); ++i) {
+         const std::string &name = menuNames[i];
+         size_t v = name.rfind("_v");
+         std::string base = name;
+         if (v != std::string::npos && matches(name, name.substr(0, v))) base = name.substr(0, v);
+         byBase.emplace(base, int(i));
+         byBase.emplace(name, int(i));
+      }
+      std::vector<int> table(fPaths.size(), -1);
+      for (size_t i = 0; i < fPaths.size(); ++i) {
+         auto found = byBase.find(fPaths[i]);
+         if (found != byBase.end()) table[i] = found->second;
+      }
+      it = fTables.emplace(menuId, std::move(table)).first;
+   }
+   fLastId = &it->first;
+   fLast = &it->second;
+   return *fLast;
+}